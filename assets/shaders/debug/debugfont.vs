@@ -1,12 +1,12 @@
 #version 330 core
-in vec3 aPos;
-in vec2 aTexCoord;
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aTexCoord;
 
 out vec3 vPos;
 out vec2 vTexCoord;
 void main()
 {
-    gl_Position = vec4(aPos, 1.0);
-    vPos = aPos;
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    vPos = vec3(aPos, 0.0);
     vTexCoord = aTexCoord;
 }
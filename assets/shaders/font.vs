@@ -2,7 +2,9 @@
 
 #version 330 core
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
+layout (location = 1) in vec3 aColor;
 out vec2 TexCoords;
+out vec3 TextColor;
 
 uniform mat4 projection;
 
@@ -10,4 +12,5 @@ void main()
 {
     gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
     TexCoords = vertex.zw;
-}
\ No newline at end of file
+    TextColor = aColor;
+}
@@ -2,11 +2,11 @@
 
 // I/O
 
+in vec4 vColor;
 out vec4 fColor;
-uniform vec4 aColor;
 
 // Main
 
 void main() {
-    fColor = aColor;
+    fColor = vColor;
 }
\ No newline at end of file
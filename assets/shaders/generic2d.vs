@@ -1,10 +1,12 @@
 #version 330 core
 layout (location = 0) in vec2 aPos;
-layout (location = 1) in vec2 aTexCoords;
+layout (location = 1) in vec4 aColor;
+
+out vec4 vColor;
 
 uniform mat4 projection;
-uniform mat4 model;
 
 void main() {
-    gl_Position = projection * model * vec4(aPos, 0.0, 1);
+    gl_Position = projection * vec4(aPos, 0.0, 1);
+    vColor = aColor;
 }
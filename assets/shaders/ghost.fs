@@ -7,7 +7,13 @@ out vec4 FragColor;
 
 #define NR_POINT_LIGHTS 4
 
-uniform vec3 viewPos;
+// See CameraBlock in rendering/uniformbuffer.h
+layout (std140) uniform CameraBlock {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
 uniform float transparency;
 uniform vec3 color;
 
@@ -5,10 +5,15 @@ layout (location = 1) in vec3 aNormal;
 out vec3 vPos;
 out vec3 vNormal;
 
+// See CameraBlock in rendering/uniformbuffer.h
+layout (std140) uniform CameraBlock {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
 uniform mat4 model;
 uniform mat3 normalMatrix;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
@@ -40,10 +40,20 @@ out vec4 FragColor;
 
 #define NR_POINT_LIGHTS 4
 
-uniform vec3 viewPos;
+// See CameraBlock in rendering/uniformbuffer.h
+layout (std140) uniform CameraBlock {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
 uniform PointLight pointLights[NR_POINT_LIGHTS];
 uniform int numPointLights;
-uniform DirLight sunLight;
+// See LightBlock in rendering/uniformbuffer.h
+layout (std140) uniform LightBlock {
+    DirLight sunLight;
+};
+
 uniform Material material;
 
 // Functions
@@ -5,9 +5,14 @@ layout (location = 2) in vec2 aTexCoords;
 
 out vec3 vPos;
 
+// See CameraBlock in rendering/uniformbuffer.h
+layout (std140) uniform CameraBlock {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 uniform vec3 scale;
 uniform float thickness;
 
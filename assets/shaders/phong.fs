@@ -43,21 +43,32 @@ in vec3 lPos;
 in vec3 vNormal;
 in vec3 lNormal;
 flat in int vSurfaceZ;
+flat in vec3 vColor;
+flat in float vTransparency;
+flat in float vReflectance;
+flat in vec3 vTexScale;
 
 out vec4 FragColor;
 
 #define NR_POINT_LIGHTS 4
 
-uniform vec3 viewPos;
+// See CameraBlock in rendering/uniformbuffer.h
+layout (std140) uniform CameraBlock {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
 uniform PointLight pointLights[NR_POINT_LIGHTS];
 uniform int numPointLights;
-uniform DirLight sunLight;
+// See LightBlock in rendering/uniformbuffer.h
+layout (std140) uniform LightBlock {
+    DirLight sunLight;
+};
+
 uniform Material material;
 uniform sampler2DArray studs;
 uniform samplerCube skybox;
-uniform float transparency;
-uniform float reflectance;
-uniform vec3 texScale;
 
 
 // Functions
@@ -84,10 +95,10 @@ void main() {
                     // We use abs(lNormal) so opposing sides "cut" from the same side
     mat3 transform = transpose(inverse(lookAlong(vec3(0, 0, 0), abs(lNormal), otherVec)));
     
-    vec2 texCoords = vec2((transform * lPos) * (transform * texScale) / 2) - vec2(mod((transform * texScale) / 4, 1));
+    vec2 texCoords = vec2((transform * lPos) * (transform * vTexScale) / 2) - vec2(mod((transform * vTexScale) / 4, 1));
 
     vec4 studPx = texture(studs, vec3(texCoords, vSurfaceZ));
-    FragColor = vec4(mix(result, vec3(studPx), studPx.w), 1) * (1-transparency);
+    FragColor = vec4(mix(result, vec3(studPx), studPx.w), 1) * (1-vTransparency);
 }
 
 mat3 lookAlong(vec3 pos, vec3 forward, vec3 up) {
@@ -114,7 +125,7 @@ vec3 calculateReflection() {
     vec3 viewDir = normalize(viewPos - vPos);
     vec3 reflectDir = reflect(viewDir, norm);
     float fresnel = (pow(1.0-max(dot(viewDir, norm), 0.0), 5.0));
-    vec3 result = sampleSkybox() * mix(/* TEMPORARY: will be replaced by setting */ 0 * /* /TEMPORARY */ fresnel * material.specular, vec3(1.0), reflectance);
+    vec3 result = sampleSkybox() * mix(/* TEMPORARY: will be replaced by setting */ 0 * /* /TEMPORARY */ fresnel * material.specular, vec3(1.0), vReflectance);
     return result;
 }
 
@@ -131,8 +142,8 @@ vec3 calculateDirectionalLight(DirLight light) {
     // float fresnel = (pow(1.0-max(dot(viewDir, norm), 0.0), 5.0));
     
     
-    vec3 ambient = light.ambient * (material.diffuse * (1.0-reflectance));
-    vec3 diffuse = light.diffuse * diff * (material.diffuse * (1.0-reflectance));
+    vec3 ambient = light.ambient * (vColor * (1.0-vReflectance));
+    vec3 diffuse = light.diffuse * diff * (vColor * (1.0-vReflectance));
     vec3 specular = light.specular * spec * material.specular;
     // specular += sampleSkybox() * fresnel * material.specular;
     
@@ -156,8 +167,8 @@ vec3 calculatePointLight(PointLight light) {
     float distance = length(light.position - vPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
 
-    vec3 ambient = light.ambient * material.diffuse;
-    vec3 diffuse = light.diffuse * diff * material.diffuse;
+    vec3 ambient = light.ambient * vColor;
+    vec3 diffuse = light.diffuse * diff * vColor;
     vec3 specular = light.specular * spec * material.specular;
 
     return (ambient + diffuse + specular) * attenuation;
@@ -3,6 +3,15 @@ layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
 
+// Per-instance attributes, see PartInstance in rendering/instancedmesh.h
+layout (location = 3) in mat4 iModel;
+layout (location = 7) in mat3 iNormalMatrix;
+layout (location = 10) in vec3 iColor;
+layout (location = 11) in vec2 iMaterial; // Transparency, reflectance
+layout (location = 12) in vec3 iSize;
+layout (location = 13) in ivec3 iSurfacesA; // Right, top, back
+layout (location = 14) in ivec3 iSurfacesB; // Left, bottom, front
+
 const int FaceRight = 0;
 const int FaceTop = 1;
 const int FaceBack = 2;	
@@ -24,23 +33,33 @@ out vec3 vNormal;
 out vec3 lNormal;
 out vec2 vTexCoords;
 flat out int vSurfaceZ;
+flat out vec3 vColor;
+flat out float vTransparency;
+flat out float vReflectance;
+flat out vec3 vTexScale;
 
-uniform mat4 model;
-uniform mat3 normalMatrix;
-uniform mat4 view;
-uniform mat4 projection;
-uniform int surfaces[6];
-uniform vec3 texScale;
+// See CameraBlock in rendering/uniformbuffer.h
+layout (std140) uniform CameraBlock {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
 
 const float faceThreshold = sqrt(2)/2;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    vPos = vec3(model * vec4(aPos, 1.0));
+    int surfaces[6] = int[6](iSurfacesA.x, iSurfacesA.y, iSurfacesA.z, iSurfacesB.x, iSurfacesB.y, iSurfacesB.z);
+
+    gl_Position = projection * view * iModel * vec4(aPos, 1.0);
+    vPos = vec3(iModel * vec4(aPos, 1.0));
     lPos = aPos;
-    vNormal = normalMatrix * aNormal;
+    vNormal = iNormalMatrix * aNormal;
     lNormal = aNormal;
+    vColor = iColor;
+    vTransparency = iMaterial.x;
+    vReflectance = iMaterial.y;
+    vTexScale = iSize;
     int vFace = FaceNone;
 
     if (dot(vec3(0, 1, 0), aNormal) > faceThreshold)
@@ -56,6 +75,6 @@ void main()
     else if (dot(vec3(0, 0, 1), aNormal) > faceThreshold)
         vFace = FaceBack;
 
-    vSurfaceZ = surfaces[vFace];
-    if (surfaces[vFace] > SurfaceUniversal) vSurfaceZ = 0;
+    vSurfaceZ = vFace == FaceNone ? 0 : surfaces[vFace];
+    if (vSurfaceZ > SurfaceUniversal) vSurfaceZ = 0;
 }
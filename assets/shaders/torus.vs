@@ -0,0 +1,31 @@
+#version 330 core
+// Vertices as generated by genTorusMesh in rendering/torus.cpp
+layout (location = 0) in vec3 aRingDir;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec3 vPos;
+out vec3 vNormal;
+out vec2 vTexCoords;
+
+// See CameraBlock in rendering/uniformbuffer.h
+layout (std140) uniform CameraBlock {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+uniform mat4 model;
+uniform mat3 normalMatrix;
+uniform float outerRadius;
+uniform float innerRadius;
+
+void main()
+{
+    vec3 aPos = aRingDir * outerRadius + aNormal * innerRadius;
+
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vPos = vec3(model * vec4(aPos, 1.0));
+    vNormal = normalMatrix * aNormal;
+    vTexCoords = aTexCoords;
+}
@@ -11,6 +11,7 @@ std::shared_ptr<DataModel> editModeDataModel = gDataModel;
 std::optional<HierarchyPreUpdateHandler> hierarchyPreUpdateHandler;
 std::optional<HierarchyPostUpdateHandler> hierarchyPostUpdateHandler;
 Handles editorToolHandles;
+thread_local bool isDetachedBuildThread = false;
 
 
 std::vector<std::shared_ptr<Instance>> currentSelection;
@@ -18,6 +19,7 @@ std::vector<PropertyUpdateHandler> propertyUpdatelisteners;
 
 
 void sendPropertyUpdatedSignal(std::shared_ptr<Instance> instance, std::string property, Variant newValue) {
+    if (isDetachedBuildThread) return;
     for (PropertyUpdateHandler handler : propertyUpdatelisteners) {
         handler(instance, property, newValue);
     }
@@ -20,5 +20,10 @@ extern std::optional<HierarchyPreUpdateHandler> hierarchyPreUpdateHandler;
 extern std::optional<HierarchyPostUpdateHandler> hierarchyPostUpdateHandler;
 extern Handles editorToolHandles;
 
+// Set on worker threads that build detached instance trees, e.g. while loading a place.
+// Hierarchy and property update handlers are skipped on those threads, as the editor
+// is not thread-safe and doesn't display those instances yet anyway
+extern thread_local bool isDetachedBuildThread;
+
 void sendPropertyUpdatedSignal(std::shared_ptr<Instance> instance, std::string property, Variant newValue);
 void addPropertyUpdateListener(PropertyUpdateHandler handler);
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "datatypes/enummeta.h"
 #include "enum/part.h"
+#include "enum/physics.h"
 #include "enum/surface.h"
 
 template <typename... E>
@@ -12,4 +13,4 @@ std::map<std::string, const Enum*> make_enum_map() {
     return map;
 }
 
-std::map<std::string, const Enum*> ENUM_MAP = make_enum_map<PartType, SurfaceType, NormalId>();
\ No newline at end of file
+std::map<std::string, const Enum*> ENUM_MAP = make_enum_map<PartType, SurfaceType, NormalId, PhysicsProfile>();
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "datatypes/enum.h"
+#include "enum/annotation.h"
+#include "datatypes/enummeta.h"
+
+enum class DEF_ENUM PhysicsProfile {
+    Custom = 0,
+    Fast = 1,
+    Balanced = 2,
+    Accurate = 3,
+};
+
+namespace EnumType {
+    extern const Enum PhysicsProfile;
+};
+
+DEF_ENUM_META(PhysicsProfile)
\ No newline at end of file
@@ -10,4 +10,9 @@ class LuaCastError : public Error {
 class DataParseError : public Error {
     public:
     inline DataParseError(std::string parsedString, std::string targetType) : Error("DataParseError", "Failed to parse '" + parsedString + "' into value of type " + targetType) {}
-};
\ No newline at end of file
+};
+
+class PlaceParseError : public Error {
+    public:
+    inline PlaceParseError(std::string message) : Error("PlaceParseError", "Failed to load place file: " + message) {}
+};
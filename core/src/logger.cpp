@@ -11,6 +11,7 @@ static std::ofstream logStream;
 static std::vector<Logger::LogListener> logListeners;
 std::string Logger::currentLogDir = "NULL";
 static std::stringstream* rawOutputBuffer = nullptr;
+static thread_local std::vector<Logger::DeferredMessage>* deferredMessages = nullptr;
 
 void Logger::init() {
     initProgramLogsDir();
@@ -36,6 +37,11 @@ void Logger::finish() {
 }
 
 void Logger::log(std::string message, Logger::LogLevel logLevel, ScriptSource source) {
+    if (deferredMessages != nullptr) {
+        deferredMessages->push_back({ logLevel, message });
+        return;
+    }
+
     std::string logLevelStr = logLevel == Logger::LogLevel::INFO ? "INFO" : 
         logLevel == Logger::LogLevel::DEBUG ? "DEBUG" :
         logLevel == Logger::LogLevel::TRACE ? "TRACE" :
@@ -66,4 +72,8 @@ void Logger::addLogListener(Logger::LogListener listener) {
 
 void Logger::resetLogListeners() {
     logListeners.clear();
+}
+
+void Logger::deferThreadMessages(std::vector<DeferredMessage>* buffer) {
+    deferredMessages = buffer;
 }
\ No newline at end of file
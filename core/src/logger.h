@@ -4,6 +4,7 @@
 #include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
 
 class Script;
 
@@ -24,6 +25,11 @@ namespace Logger {
 
     typedef std::function<void(LogLevel logLevel, std::string message, ScriptSource source)> LogListener;
 
+    struct DeferredMessage {
+        LogLevel logLevel;
+        std::string message;
+    };
+
     extern std::string currentLogDir;
 
     void init();
@@ -31,6 +37,9 @@ namespace Logger {
     void finish();
     void addLogListener(LogListener);
     void resetLogListeners(); // Testing only!
+    // While set, messages logged on the calling thread are stored in the buffer instead of
+    // being written out, so that worker threads can hand them over to the main thread
+    void deferThreadMessages(std::vector<DeferredMessage>* buffer);
 
     void log(std::string message, LogLevel logLevel, ScriptSource source = {});
     inline void info(std::string message) { log(message, LogLevel::INFO); }
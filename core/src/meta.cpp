@@ -8,6 +8,7 @@
 #include "datatypes/enum.h"
 #include "datatypes/primitives.h"
 #include "enum/part.h"
+#include "enum/physics.h"
 #include "enum/surface.h"
 #include <typeindex>
 #include <vector>
@@ -26,6 +27,7 @@ std::map<std::type_index, const Enum*> ENUM_TYPE = {
     { index<SurfaceType>(), &EnumType::SurfaceType },
     { index<NormalId>(), &EnumType::NormalId },
     { index<PartType>(), &EnumType::PartType },
+    { index<PhysicsProfile>(), &EnumType::PhysicsProfile },
 };
 
 // Integral data types
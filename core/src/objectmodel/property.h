@@ -13,6 +13,8 @@ class Instance;
 using PropertyGetter = std::function<Variant(std::shared_ptr<Instance>)>;
 using PropertySetter = std::function<void(std::shared_ptr<Instance>, Variant)>;
 using PropertyListener = std::function<void(std::shared_ptr<Instance>, std::string name, Variant oldValue, Variant newValue)>;
+// Copies the property's value directly between two instances of the same class, used when cloning
+using PropertyCopier = std::function<void(Instance* from, Instance* to)>;
 
 template <typename C>
 using MemberPropertyListener = void (C::*)(std::string name, Variant oldValue, Variant newValue);
@@ -30,6 +32,8 @@ struct InstanceProperty {
     PropertyGetter getter;
     PropertySetter setter;
     std::optional<PropertyListener> listener;
+    // If not present, the value is copied through the getter and setter instead
+    std::optional<PropertyCopier> copier;
 };
 
 template <typename T, typename C>
@@ -48,7 +52,10 @@ InstanceProperty def_property(std::string name, T C::* ref, PropertyFlags flags
             auto obj = std::dynamic_pointer_cast<C>(instance);
             obj.get()->*ref = value.get<T>();
         },
-        listener
+        listener,
+        [ref](Instance* from, Instance* to) {
+            static_cast<C*>(to)->*ref = static_cast<C*>(from)->*ref;
+        }
     };
 }
 
@@ -78,7 +85,8 @@ InstanceProperty def_property(std::string name, PropertySupplier<T, C> supplier,
             Logger::fatalError("Property cannot be assigned");
             panic();
         },
-        listener
+        listener,
+        {}
     };
 }
 
@@ -46,6 +46,7 @@ InstanceProperty def_parent_property(const InstanceType& typeMeta) {
         [](std::shared_ptr<Instance> instance, Variant value) {
             instance->SetParent(value.get<std::shared_ptr<Instance>>());
         },
+        std::nullopt,
         std::nullopt
     };
 }
@@ -99,7 +100,7 @@ bool Instance::SetParent(nullable std::shared_ptr<Instance> newParent) {
         return false;
 
     auto lastParent = GetParent();
-    if (hierarchyPreUpdateHandler.has_value()) hierarchyPreUpdateHandler.value()(this->shared_from_this(), lastParent, newParent);
+    if (hierarchyPreUpdateHandler.has_value() && !isDetachedBuildThread) hierarchyPreUpdateHandler.value()(this->shared_from_this(), lastParent, newParent);
     // If we currently have a parent, remove ourselves from it before adding ourselves to the new one
     if (!this->parent.expired()) {
         auto oldParent = this->parent.lock();
@@ -112,7 +113,7 @@ bool Instance::SetParent(nullable std::shared_ptr<Instance> newParent) {
     this->parent = newParent;
     // TODO: Add code for sending signals for parent updates
     // TODO: Yeahhh maybe this isn't the best way of doing this?
-    if (hierarchyPostUpdateHandler.has_value()) hierarchyPostUpdateHandler.value()(this->shared_from_this(), lastParent, newParent);
+    if (hierarchyPostUpdateHandler.has_value() && !isDetachedBuildThread) hierarchyPostUpdateHandler.value()(this->shared_from_this(), lastParent, newParent);
 
     this->OnParentUpdated(lastParent, newParent);
 
@@ -283,6 +284,10 @@ void Instance::OnWorkspaceRemoved(std::shared_ptr<Workspace> oldWorkspace) {
     // Empty stub
 }
 
+void Instance::OnCloned() {
+    // Empty stub
+}
+
 // Properties
 
 result<Variant, MemberNotFound> Instance::GetProperty(std::string name) {
@@ -406,16 +411,14 @@ void Instance::Serialize(pugi::xml_node parent, RefStateSerialize state) {
             if (refWeak.expired()) continue;
 
             auto ref = refWeak.lock();
-            auto remappedRef = state->remappedInstances[ref]; // TODO: I think this is okay? Maybe?? Add null check?
+            int* remappedRef = state->remappedInstances.find(ref.get());
             
-            if (remappedRef != "") {
+            if (remappedRef) {
                 // If the instance has already been remapped, set the new value
-                propertyNode.text().set(remappedRef);
+                propertyNode.text().set(("OB" + std::to_string(*remappedRef)).c_str());
             } else {
                 // Otheriise, queue this property to be updated later, and keep its current value
-                auto& refs = state->refsAwaitingRemap[ref];
-                refs.push_back(propertyNode);
-                state->refsAwaitingRemap[ref] = refs;
+                state->refsAwaitingRemap[ref.get()].push_back(propertyNode);
             }
         } else {
             GetProperty(name).expect("Declared property is missing").Serialize(propertyNode);
@@ -423,15 +426,18 @@ void Instance::Serialize(pugi::xml_node parent, RefStateSerialize state) {
     }
 
     // Remap self
-    std::string remappedId = "OB" + std::to_string(state->count++);
-    state->remappedInstances[shared_from_this()] = remappedId;
+    int id = state->count++;
+    state->remappedInstances[this] = id;
+    std::string remappedId = "OB" + std::to_string(id);
     node.append_attribute("referent").set_value(remappedId);
 
     // Remap queued properties
-    for (pugi::xml_node ref : state->refsAwaitingRemap[shared_from_this()]) {
-        ref.text().set(remappedId);
+    if (std::vector<pugi::xml_node>* refs = state->refsAwaitingRemap.find(this)) {
+        for (pugi::xml_node ref : *refs) {
+            ref.text().set(remappedId);
+        }
+        state->refsAwaitingRemap.erase(this);
     }
-    state->refsAwaitingRemap[shared_from_this()].clear();
 
     // Add children
     for (std::shared_ptr<Instance> child : this->children) {
@@ -457,13 +463,28 @@ result<std::shared_ptr<Instance>, NoSuchInstance> Instance::Deserialize(pugi::xm
 
     // const InstanceType* type = INSTANCE_MAP.at(className);
 
-    // Read properties
-    pugi::xml_node propertiesNode = node.child("Properties");
+    object->DeserializeProperties(node.child("Properties"), state);
+    object->DeserializeReferent(node.attribute("referent").value(), state);
+
+    // Read children
+    for (pugi::xml_node childNode : node.children("Item")) {
+        result<std::shared_ptr<Instance>, NoSuchInstance> child = Instance::Deserialize(childNode, state);
+        if (child.isError()) {
+            std::get<NoSuchInstance>(child.error().value()).logMessage();
+            continue;
+        }
+        object->AddChild(child.expect());
+    }
+
+    return object;
+}
+
+void Instance::DeserializeProperties(pugi::xml_node propertiesNode, RefStateDeserialize state) {
     for (pugi::xml_node propertyNode : propertiesNode) {
         std::string propertyName = propertyNode.attribute("name").value();
-        auto meta_ = object->GetPropertyMeta(propertyName);
+        auto meta_ = GetPropertyMeta(propertyName);
         if (!meta_) {
-            Logger::fatalErrorf("Attempt to set unknown property '%s' of %s", propertyName.c_str(), object->GetType().className.c_str());
+            Logger::fatalErrorf("Attempt to set unknown property '%s' of %s", propertyName.c_str(), GetType().className.c_str());
             continue;
         }
         auto meta = meta_.expect();
@@ -474,18 +495,16 @@ result<std::shared_ptr<Instance>, NoSuchInstance> Instance::Deserialize(pugi::xm
                 continue;
 
             std::string refId = propertyNode.text().as_string();
-            auto remappedRef = state->remappedInstances[refId]; // TODO: I think this is okay? Maybe?? Add null check?
+            std::shared_ptr<Instance>* remappedRef = state->remappedInstances.find(refId);
             
             if (remappedRef) {
                 // If the instance has already been remapped, set the new value
-                object->SetProperty(propertyName, InstanceRef(remappedRef)).expect();
+                SetProperty(propertyName, InstanceRef(*remappedRef)).expect();
             } else {
                 // Otheriise, queue this property to be updated later, and keep its current value
-                auto& refs = state->refsAwaitingRemap[refId];
-                refs.push_back(std::make_pair(object, propertyName));
-                state->refsAwaitingRemap[refId] = refs;
+                state->refsAwaitingRemap[refId].push_back(std::make_pair(shared_from_this(), propertyName));
 
-                object->SetProperty(propertyName, InstanceRef()).expect();
+                SetProperty(propertyName, InstanceRef()).expect();
             }
         } else {
             auto valueResult = Variant::Deserialize(propertyNode, meta.type);
@@ -494,83 +513,84 @@ result<std::shared_ptr<Instance>, NoSuchInstance> Instance::Deserialize(pugi::xm
                 continue;
             }
             auto value = valueResult.expect();
-            object->SetProperty(propertyName, value).expect("Declared property was missing");
+            SetProperty(propertyName, value).expect("Declared property was missing");
         }
     }
+}
 
-    // Remap self
-    std::string remappedId = node.attribute("referent").value();
-    state->remappedInstances[remappedId] = object;
+void Instance::DeserializeReferent(std::string remappedId, RefStateDeserialize state) {
+    state->remappedInstances[remappedId] = shared_from_this();
 
     // Remap queued properties
-    for (std::pair<std::shared_ptr<Instance>, std::string> ref : state->refsAwaitingRemap[remappedId]) {
-        ref.first->SetProperty(ref.second, InstanceRef(object)).expect();
-    }
-    state->refsAwaitingRemap[remappedId].clear();
-
-    // Read children
-    for (pugi::xml_node childNode : node.children("Item")) {
-        result<std::shared_ptr<Instance>, NoSuchInstance> child = Instance::Deserialize(childNode, state);
-        if (child.isError()) {
-            std::get<NoSuchInstance>(child.error().value()).logMessage();
-            continue;
+    if (auto refs = state->refsAwaitingRemap.find(remappedId)) {
+        for (std::pair<std::shared_ptr<Instance>, std::string>& ref : *refs) {
+            ref.first->SetProperty(ref.second, InstanceRef(shared_from_this())).expect();
         }
-        object->AddChild(child.expect());
+        state->refsAwaitingRemap.erase(remappedId);
     }
-
-    return object;
 }
 
-nullable std::shared_ptr<Instance> Instance::Clone(RefStateClone state) {
-    if (state == nullptr) state = std::make_shared<__RefStateClone>();
-    // TODO: Handle case where this is NotCreatable
-    std::shared_ptr<Instance> newInstance = GetType().constructor.value()();
-
-    // Copy properties
-    for (std::string property : GetProperties()) {
-        PropertyMeta meta = GetPropertyMeta(property).expect();
-        
-        if (meta.flags & (PROP_READONLY | PROP_NOSAVE)) continue;
+void Instance::cloneProperties(std::shared_ptr<Instance> target, RefStateClone state) {
+    // The clone isn't part of any tree yet, so values are written directly without
+    // going through SetProperty. Update signals are not needed, and whatever the
+    // listeners would have derived is rebuilt by OnCloned below
+    for (auto& [name, property] : GetType().properties) {
+        if (property.flags & (PROP_READONLY | PROP_NOSAVE)) continue;
 
         // Update std::shared_ptr<Instance> properties using map above
-        if (meta.type.descriptor == &InstanceRef::TYPE) {
-            std::weak_ptr<Instance> refWeak = GetProperty(property).expect().get<InstanceRef>();
+        if (property.type.descriptor == &InstanceRef::TYPE) {
+            std::weak_ptr<Instance> refWeak = property.getter(shared_from_this()).get<InstanceRef>();
             if (refWeak.expired()) continue;
 
             auto ref = refWeak.lock();
-            auto remappedRef = state->remappedInstances[ref]; // TODO: I think this is okay? Maybe?? Add null check?
+            std::shared_ptr<Instance>* remappedRef = state->remappedInstances.find(ref.get());
             
             if (remappedRef) {
                 // If the instance has already been remapped, set the new value
-                newInstance->SetProperty(property, InstanceRef(remappedRef)).expect();
+                property.setter(target, InstanceRef(*remappedRef));
             } else {
                 // Otheriise, queue this property to be updated later, and keep its current value
-                auto& refs = state->refsAwaitingRemap[ref];
-                refs.push_back(std::make_pair(newInstance, property));
-                state->refsAwaitingRemap[ref] = refs;
+                state->refsAwaitingRemap[ref.get()].push_back(std::make_pair(target, name));
 
-                newInstance->SetProperty(property, InstanceRef(ref)).expect();
+                property.setter(target, InstanceRef(ref));
             }
+        } else if (property.copier) {
+            property.copier.value()(this, target.get());
         } else {
-            Variant value = GetProperty(property).expect();
-            newInstance->SetProperty(property, value).expect();
+            property.setter(target, property.getter(shared_from_this()));
         }
     }
 
     // Remap self
-    state->remappedInstances[shared_from_this()] = newInstance;
+    state->remappedInstances[this] = target;
 
     // Remap queued properties
-    for (std::pair<std::shared_ptr<Instance>, std::string> ref : state->refsAwaitingRemap[shared_from_this()]) {
-        ref.first->SetProperty(ref.second, InstanceRef(newInstance)).expect();
+    if (auto refs = state->refsAwaitingRemap.find(this)) {
+        for (std::pair<std::shared_ptr<Instance>, std::string>& ref : *refs) {
+            ref.first->GetType().properties.at(ref.second).setter(ref.first, InstanceRef(target));
+        }
+        state->refsAwaitingRemap.erase(this);
     }
-    state->refsAwaitingRemap[shared_from_this()].clear();
 
-    // Clone children
-    for (std::shared_ptr<Instance> child : GetChildren()) {
+    target->OnCloned();
+}
+
+nullable std::shared_ptr<Instance> Instance::Clone(RefStateClone state) {
+    if (state == nullptr) state = std::make_shared<__RefStateClone>();
+    // TODO: Handle case where this is NotCreatable
+    std::shared_ptr<Instance> newInstance = GetType().constructor.value()();
+
+    cloneProperties(newInstance, state);
+
+    // Clone children. The new tree is detached, so they are linked in directly rather than
+    // through SetParent, and the ancestry of the whole tree is updated once it is parented
+    newInstance->children.reserve(children.size());
+    for (std::shared_ptr<Instance>& child : children) {
         nullable std::shared_ptr<Instance> clonedChild = child->Clone(state);
-        if (clonedChild)
-            newInstance->AddChild(clonedChild);
+        if (!clonedChild) continue;
+
+        clonedChild->parent = newInstance;
+        newInstance->children.push_back(clonedChild);
     }
 
     return newInstance;
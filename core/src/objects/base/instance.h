@@ -72,6 +72,12 @@ protected:
     virtual void OnAncestryChanged(nullable std::shared_ptr<Instance> child, nullable std::shared_ptr<Instance> newParent);
     virtual void OnWorkspaceAdded(nullable std::shared_ptr<Workspace> oldWorkspace, std::shared_ptr<Workspace> newWorkspace);
     virtual void OnWorkspaceRemoved(std::shared_ptr<Workspace> oldWorkspace);
+    // Called on a clone once its properties are copied. Copying doesn't run property listeners, so
+    // state they derive has to be rebuilt here. References may not have been remapped yet
+    virtual void OnCloned();
+
+    // Copies this instance's properties onto its (detached) clone, and remaps references to and from it
+    void cloneProperties(std::shared_ptr<Instance> target, RefStateClone state);
 
     // The root data model this object is a descendant of
     nullable std::shared_ptr<DataModel> dataModel();
@@ -149,6 +155,10 @@ public:
     // Serialization
     void Serialize(pugi::xml_node parent, RefStateSerialize state = {});
     static result<std::shared_ptr<Instance>, NoSuchInstance> Deserialize(pugi::xml_node node, RefStateDeserialize state = {});
+    // Applies the properties of an Item's <Properties> node to this instance
+    void DeserializeProperties(pugi::xml_node propertiesNode, RefStateDeserialize state);
+    // Registers this instance under its referent, and resolves the references that were waiting on it
+    void DeserializeReferent(std::string referent, RefStateDeserialize state);
     nullable std::shared_ptr<Instance> Clone(RefStateClone state = {});
     inline nullable std::shared_ptr<Instance> ScriptClone() { return Clone(); };
 };
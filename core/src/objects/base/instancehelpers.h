@@ -20,6 +20,9 @@ InstanceProperty def_property_apex(const InstanceType& typeMeta, std::string nam
             auto obj = std::dynamic_pointer_cast<C>(instance);
             obj.get()->*ref = value.get<T>();
         },
-        listener
+        listener,
+        [ref](Instance* from, Instance* to) {
+            static_cast<C*>(to)->*ref = static_cast<C*>(from)->*ref;
+        }
     };
 }
\ No newline at end of file
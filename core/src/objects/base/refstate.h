@@ -3,25 +3,30 @@
 // Helper struct used for remapping reference when cloning/serializing
 
 #include "datatypes/base.h"
-#include <map>
+#include "openhashmap.h"
 #include <memory>
+#include <string>
 #include <vector>
 class Instance;
 
+// Entries in refsAwaitingRemap only exist for instances that are actually
+// referred to, and are erased once resolved
 template <typename T, typename U, typename K>
 struct __RefState {
-    std::map<K, U> remappedInstances;
-    std::map<K, std::vector<T>> refsAwaitingRemap;
+    OpenHashMap<K, U> remappedInstances;
+    OpenHashMap<K, std::vector<T>> refsAwaitingRemap;
     int count = 0;
 };
 
 template <typename T, typename U, typename K>
 using RefState = std::shared_ptr<__RefState<T, U, K>>;
 
-typedef __RefState<std::pair<std::shared_ptr<Instance>, std::string>, std::shared_ptr<Instance>, std::shared_ptr<Instance>> __RefStateClone;
-typedef __RefState<pugi::xml_node, std::string, std::shared_ptr<Instance>> __RefStateSerialize;
+// Source instances are alive for the whole clone/save, so they are keyed by raw pointer.
+// Saved instances are given integer ids, which become their "OB<id>" referent
+typedef __RefState<std::pair<std::shared_ptr<Instance>, std::string>, std::shared_ptr<Instance>, Instance*> __RefStateClone;
+typedef __RefState<pugi::xml_node, int, Instance*> __RefStateSerialize;
 typedef __RefState<std::pair<std::shared_ptr<Instance>, std::string>, std::shared_ptr<Instance>, std::string> __RefStateDeserialize;
 
 typedef std::shared_ptr<__RefStateClone> RefStateClone;
 typedef std::shared_ptr<__RefStateSerialize> RefStateSerialize;
-typedef std::shared_ptr<__RefStateDeserialize> RefStateDeserialize;
\ No newline at end of file
+typedef std::shared_ptr<__RefStateDeserialize> RefStateDeserialize;
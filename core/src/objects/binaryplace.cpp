@@ -0,0 +1,499 @@
+#include "binaryplace.h"
+#include "datatypes/variant.h"
+#include "datatypes/primitives.h"
+#include "error/instance.h"
+#include "objects/base/instance.h"
+#include "objects/base/member.h"
+#include "objects/meta.h"
+#include "logger.h"
+#include "version.h"
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <unordered_map>
+
+#if defined(_POSIX_VERSION) || defined(__linux) || defined(__linux__) || defined(__unix__)
+#define BINARY_PLACE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#elif defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+#define BINARY_PLACE_WIN32
+#include <windows.h>
+#endif
+
+// Read-only view of a whole file mapped into memory
+class MappedFile {
+    const uint8_t* _data = nullptr;
+    size_t _size = 0;
+#ifdef BINARY_PLACE_WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+
+public:
+    MappedFile(std::string path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    inline bool isOpen() { return _data != nullptr; }
+    inline const uint8_t* data() { return _data; }
+    inline size_t size() { return _size; }
+};
+
+#ifdef BINARY_PLACE_POSIX
+MappedFile::MappedFile(std::string path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            _data = (const uint8_t*)mapped;
+            _size = st.st_size;
+        }
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (_data) munmap((void*)_data, _size);
+}
+#elif defined(BINARY_PLACE_WIN32)
+MappedFile::MappedFile(std::string path) {
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return;
+
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) return;
+
+    _data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (_data) _size = fileSize.QuadPart;
+}
+
+MappedFile::~MappedFile() {
+    if (_data) UnmapViewOfFile(_data);
+    if (mapping != NULL) CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+}
+#endif
+
+class BinaryWriter {
+    std::string buffer;
+public:
+    template <typename T>
+    void write(T value) { buffer.append((const char*)&value, sizeof(T)); }
+
+    void writeString(const std::string& str) {
+        write<uint32_t>(str.size());
+        buffer.append(str);
+    }
+
+    inline const std::string& data() { return buffer; }
+};
+
+// Cursor over the mapped file. Reading past the end yields zeroes and marks
+// the reader as overrun, which is checked once decoding is done
+class BinaryReader {
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool overrun = false;
+public:
+    BinaryReader(const uint8_t* data, size_t size) : pos(data), end(data + size) {}
+
+    template <typename T>
+    T read() {
+        T value {};
+        if ((size_t)(end - pos) < sizeof(T)) {
+            overrun = true;
+            pos = end;
+            return value;
+        }
+        memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string readString() {
+        uint32_t length = read<uint32_t>();
+        if ((size_t)(end - pos) < length) {
+            overrun = true;
+            pos = end;
+            return "";
+        }
+        std::string str((const char*)pos, length);
+        pos += length;
+        return str;
+    }
+
+    // Guards against allocating for counts that could never fit in the rest
+    // of the file, as every entry takes at least one byte
+    bool fits(uint32_t count) { return count <= (size_t)(end - pos); }
+
+    inline bool failed() { return overrun; }
+};
+
+static std::optional<BinaryValueType> valueTypeOf(const TypeMeta& type) {
+    if (type.descriptor == &BOOL_TYPE) return BinaryValueType::Bool;
+    if (type.descriptor == &INT_TYPE) return BinaryValueType::Int;
+    if (type.descriptor == &FLOAT_TYPE) return BinaryValueType::Float;
+    if (type.descriptor == &STRING_TYPE) return BinaryValueType::String;
+    if (type.descriptor == &Vector3::TYPE) return BinaryValueType::Vector3;
+    if (type.descriptor == &CFrame::TYPE) return BinaryValueType::CFrame;
+    if (type.descriptor == &Color3::TYPE) return BinaryValueType::Color3;
+    if (type.descriptor == &EnumItem::TYPE) return BinaryValueType::EnumItem;
+    if (type.descriptor == &InstanceRef::TYPE) return BinaryValueType::Ref;
+    return std::nullopt;
+}
+
+static void writeValue(BinaryWriter& writer, BinaryValueType type, Variant value, std::unordered_map<Instance*, int32_t>& indices) {
+    switch (type) {
+    case BinaryValueType::Bool:
+        writer.write<uint8_t>(value.get<bool>());
+        break;
+    case BinaryValueType::Int:
+        writer.write<int32_t>(value.get<int>());
+        break;
+    case BinaryValueType::Float:
+        writer.write<float>(value.get<float>());
+        break;
+    case BinaryValueType::String:
+        writer.writeString(value.get<std::string>());
+        break;
+    case BinaryValueType::Vector3: {
+        Vector3 vec = value.get<Vector3>();
+        writer.write<float>(vec.X());
+        writer.write<float>(vec.Y());
+        writer.write<float>(vec.Z());
+        break;
+    }
+    case BinaryValueType::CFrame: {
+        // Same component order as the CFrame constructor (position, then R00..R22)
+        CFrame cframe = value.get<CFrame>();
+        glm::mat3 rot = cframe.RotMatrix();
+        writer.write<float>(cframe.X());
+        writer.write<float>(cframe.Y());
+        writer.write<float>(cframe.Z());
+        for (int row = 0; row < 3; row++)
+            for (int col = 0; col < 3; col++)
+                writer.write<float>(rot[col][row]);
+        break;
+    }
+    case BinaryValueType::Color3: {
+        Color3 color = value.get<Color3>();
+        writer.write<float>(color.R());
+        writer.write<float>(color.G());
+        writer.write<float>(color.B());
+        break;
+    }
+    case BinaryValueType::EnumItem:
+        writer.write<int32_t>(value.get<EnumItem>().Value());
+        break;
+    case BinaryValueType::Ref: {
+        // References to instances outside of the saved tree are dropped
+        std::shared_ptr<Instance> ref = value.get<InstanceRef>();
+        auto it = ref ? indices.find(ref.get()) : indices.end();
+        writer.write<int32_t>(it != indices.end() ? it->second : -1);
+        break;
+    }
+    }
+}
+
+// Reads a single value. References are returned as their instance index, to
+// be resolved once every instance exists
+static std::optional<Variant> readValue(BinaryReader& reader, BinaryValueType type, const TypeMeta& meta) {
+    switch (type) {
+    case BinaryValueType::Bool:
+        return Variant(reader.read<uint8_t>() != 0);
+    case BinaryValueType::Int:
+        return Variant((int)reader.read<int32_t>());
+    case BinaryValueType::Float:
+        return Variant(reader.read<float>());
+    case BinaryValueType::String:
+        return Variant(reader.readString());
+    case BinaryValueType::Vector3: {
+        float x = reader.read<float>(), y = reader.read<float>(), z = reader.read<float>();
+        return Variant(Vector3(x, y, z));
+    }
+    case BinaryValueType::CFrame: {
+        float c[12];
+        for (int i = 0; i < 12; i++) c[i] = reader.read<float>();
+        return Variant(CFrame(c[0], c[1], c[2], c[3], c[4], c[5], c[6], c[7], c[8], c[9], c[10], c[11]));
+    }
+    case BinaryValueType::Color3: {
+        float r = reader.read<float>(), g = reader.read<float>(), b = reader.read<float>();
+        return Variant(Color3(r, g, b));
+    }
+    case BinaryValueType::EnumItem: {
+        int32_t value = reader.read<int32_t>();
+        if (meta.descriptor != &EnumItem::TYPE) return std::nullopt;
+        std::optional<EnumItem> item = meta.enum_->FromValue(value);
+        if (!item) return std::nullopt;
+        return Variant(item.value());
+    }
+    case BinaryValueType::Ref:
+        return Variant((int)reader.read<int32_t>());
+    }
+
+    return std::nullopt;
+}
+
+static void collectInstances(std::shared_ptr<Instance> instance, int32_t parentIndex, std::vector<std::shared_ptr<Instance>>& instances, std::vector<int32_t>& parents) {
+    int32_t index = instances.size();
+    instances.push_back(instance);
+    parents.push_back(parentIndex);
+
+    for (std::shared_ptr<Instance> child : instance->GetChildren())
+        collectInstances(child, index, instances, parents);
+}
+
+bool isBinaryPlaceFile(std::string path) {
+    std::ifstream inStream(path, std::ios::binary);
+    char magic[BINARY_PLACE_MAGIC_SIZE];
+    if (!inStream.read(magic, BINARY_PLACE_MAGIC_SIZE)) return false;
+    return memcmp(magic, BINARY_PLACE_MAGIC, BINARY_PLACE_MAGIC_SIZE) == 0;
+}
+
+void saveBinaryPlace(std::vector<std::shared_ptr<Instance>> roots, std::string path) {
+    struct PropertyChunk {
+        std::string name;
+        uint32_t nameIndex;
+        BinaryValueType type;
+    };
+
+    // Number instances depth-first
+    std::vector<std::shared_ptr<Instance>> instances;
+    std::vector<int32_t> parents;
+    for (std::shared_ptr<Instance> root : roots)
+        collectInstances(root, -1, instances, parents);
+
+    std::unordered_map<Instance*, int32_t> indices;
+    for (size_t i = 0; i < instances.size(); i++)
+        indices[instances[i].get()] = i;
+
+    // Group instances by class
+    std::vector<std::string> classNames;
+    std::unordered_map<std::string, uint32_t> classIndices;
+    std::vector<std::vector<int32_t>> classInstances;
+    std::vector<uint32_t> instanceClasses;
+    for (size_t i = 0; i < instances.size(); i++) {
+        std::string className = instances[i]->GetType().className;
+        auto it = classIndices.find(className);
+        if (it == classIndices.end()) {
+            it = classIndices.emplace(className, classNames.size()).first;
+            classNames.push_back(className);
+            classInstances.emplace_back();
+        }
+        classInstances[it->second].push_back(i);
+        instanceClasses.push_back(it->second);
+    }
+
+    // Every instance of a class has the same properties, so the chunk layout
+    // is taken from the first one. Property names are interned across classes
+    std::vector<std::string> propertyNames;
+    std::unordered_map<std::string, uint32_t> propertyIndices;
+    std::vector<std::vector<PropertyChunk>> classChunks;
+    for (std::vector<int32_t>& members : classInstances) {
+        std::shared_ptr<Instance> first = instances[members[0]];
+        std::vector<PropertyChunk> chunks;
+
+        for (std::string name : first->GetProperties()) {
+            PropertyMeta meta = first->GetPropertyMeta(name).expect("Meta of declared property is missing");
+            if (meta.flags & (PROP_NOSAVE | PROP_READONLY)) continue;
+
+            std::optional<BinaryValueType> type = valueTypeOf(meta.type);
+            if (!type) continue; // No binary representation for this type
+
+            auto it = propertyIndices.find(name);
+            if (it == propertyIndices.end()) {
+                it = propertyIndices.emplace(name, propertyNames.size()).first;
+                propertyNames.push_back(name);
+            }
+            chunks.push_back({ name, it->second, type.value() });
+        }
+
+        classChunks.push_back(chunks);
+    }
+
+    BinaryWriter writer;
+    for (int i = 0; i < BINARY_PLACE_MAGIC_SIZE; i++)
+        writer.write<char>(BINARY_PLACE_MAGIC[i]);
+    writer.write<uint32_t>(BINARY_PLACE_VERSION);
+    writer.writeString(BUILD_VERSION);
+    writer.writeString(BUILD_COMMIT_HASH);
+
+    writer.write<uint32_t>(classNames.size());
+    for (size_t i = 0; i < classNames.size(); i++) {
+        writer.writeString(classNames[i]);
+        writer.write<uint32_t>(classInstances[i].size());
+    }
+
+    writer.write<uint32_t>(propertyNames.size());
+    for (std::string& name : propertyNames)
+        writer.writeString(name);
+
+    writer.write<uint32_t>(instances.size());
+    for (size_t i = 0; i < instances.size(); i++) {
+        writer.write<uint32_t>(instanceClasses[i]);
+        writer.write<int32_t>(parents[i]);
+    }
+
+    for (size_t c = 0; c < classNames.size(); c++) {
+        writer.write<uint32_t>(classChunks[c].size());
+        for (PropertyChunk& chunk : classChunks[c]) {
+            writer.write<uint32_t>(chunk.nameIndex);
+            writer.write<uint8_t>((uint8_t)chunk.type);
+            for (int32_t index : classInstances[c])
+                writeValue(writer, chunk.type, instances[index]->GetProperty(chunk.name).expect("Declared property is missing"), indices);
+        }
+    }
+
+    std::ofstream outStream(path, std::ios::binary);
+    outStream.write(writer.data().data(), writer.data().size());
+}
+
+result<std::vector<std::shared_ptr<Instance>>, PlaceParseError> loadBinaryPlace(std::string path) {
+    struct PendingRef {
+        std::shared_ptr<Instance> instance;
+        std::string property;
+        int32_t target;
+    };
+
+    MappedFile file(path);
+    if (!file.isOpen())
+        return PlaceParseError("Could not open file '" + path + "'");
+
+    BinaryReader reader(file.data(), file.size());
+
+    char magic[BINARY_PLACE_MAGIC_SIZE];
+    for (int i = 0; i < BINARY_PLACE_MAGIC_SIZE; i++)
+        magic[i] = reader.read<char>();
+    if (memcmp(magic, BINARY_PLACE_MAGIC, BINARY_PLACE_MAGIC_SIZE) != 0)
+        return PlaceParseError("Not a binary place file");
+
+    uint32_t version = reader.read<uint32_t>();
+    if (version > BINARY_PLACE_VERSION)
+        return PlaceParseError("Unsupported format version " + std::to_string(version));
+    reader.readString(); // Build version
+    reader.readString(); // Build commit
+
+    // Class table
+    uint32_t classCount = reader.read<uint32_t>();
+    if (!reader.fits(classCount)) return PlaceParseError("Unexpected end of file");
+    std::vector<std::optional<InstanceConstructor>> constructors(classCount);
+    std::vector<uint32_t> classSizes(classCount);
+    for (uint32_t c = 0; c < classCount; c++) {
+        std::string className = reader.readString();
+        classSizes[c] = reader.read<uint32_t>();
+
+        if (INSTANCE_MAP.count(className) == 0 || !INSTANCE_MAP[className]->constructor.has_value()) {
+            NoSuchInstance(className).logMessage();
+            continue;
+        }
+        constructors[c] = INSTANCE_MAP[className]->constructor;
+    }
+
+    // Property name table
+    uint32_t propertyCount = reader.read<uint32_t>();
+    if (!reader.fits(propertyCount)) return PlaceParseError("Unexpected end of file");
+    std::vector<std::string> propertyNames(propertyCount);
+    for (uint32_t p = 0; p < propertyCount; p++)
+        propertyNames[p] = reader.readString();
+
+    // Referent table. Instances of unknown classes are left null, and dropped
+    // along with their descendants
+    uint32_t instanceCount = reader.read<uint32_t>();
+    if (!reader.fits(instanceCount)) return PlaceParseError("Unexpected end of file");
+    std::vector<std::shared_ptr<Instance>> instances(instanceCount);
+    std::vector<int32_t> parents(instanceCount);
+    std::vector<std::vector<uint32_t>> classInstances(classCount);
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        uint32_t classIndex = reader.read<uint32_t>();
+        parents[i] = reader.read<int32_t>();
+
+        if (classIndex >= classCount || parents[i] < -1 || parents[i] >= (int32_t)i)
+            return PlaceParseError("Malformed referent table");
+
+        classInstances[classIndex].push_back(i);
+        if (constructors[classIndex])
+            instances[i] = constructors[classIndex].value()();
+    }
+
+    for (uint32_t c = 0; c < classCount; c++) {
+        if (classInstances[c].size() != classSizes[c])
+            return PlaceParseError("Instance count mismatch in class table");
+    }
+
+    // Property chunks
+    std::vector<PendingRef> pendingRefs;
+    for (uint32_t c = 0; c < classCount; c++) {
+        std::vector<uint32_t>& members = classInstances[c];
+        std::shared_ptr<Instance> first = members.empty() ? nullptr : instances[members[0]];
+
+        uint32_t chunkCount = reader.read<uint32_t>();
+        for (uint32_t k = 0; k < chunkCount && !reader.failed(); k++) {
+            uint32_t nameIndex = reader.read<uint32_t>();
+            uint8_t typeTag = reader.read<uint8_t>();
+            if (nameIndex >= propertyCount || typeTag < (uint8_t)BinaryValueType::Bool || typeTag > (uint8_t)BinaryValueType::Ref)
+                return PlaceParseError("Malformed property chunk");
+
+            std::string& name = propertyNames[nameIndex];
+            BinaryValueType type = (BinaryValueType)typeTag;
+
+            // Values are still decoded when they can't be applied, to skip past them
+            std::optional<PropertyMeta> meta;
+            if (first) {
+                auto meta_ = first->GetPropertyMeta(name);
+                if (!meta_) {
+                    Logger::fatalErrorf("Attempt to set unknown property '%s' of %s", name.c_str(), first->GetType().className.c_str());
+                } else if (valueTypeOf(meta_.expect().type) != type || (meta_.expect().flags & PROP_READONLY)) {
+                    Logger::errorf("Property '%s' of %s has an incompatible type, skipping", name.c_str(), first->GetType().className.c_str());
+                } else {
+                    meta.emplace(meta_.expect());
+                }
+            }
+
+            for (uint32_t index : members) {
+                std::optional<Variant> value = readValue(reader, type, meta ? meta->type : TypeMeta(&BOOL_TYPE));
+                if (!meta || !value) continue;
+
+                if (type == BinaryValueType::Ref)
+                    pendingRefs.push_back({ instances[index], name, value->get<int>() });
+                else
+                    instances[index]->SetProperty(name, value.value()).expect("Declared property was missing");
+            }
+        }
+    }
+
+    if (reader.failed())
+        return PlaceParseError("Unexpected end of file");
+
+    // Resolve references now that every instance exists
+    for (PendingRef& ref : pendingRefs) {
+        if (ref.target < 0 || ref.target >= (int32_t)instanceCount || !instances[ref.target]) continue;
+        ref.instance->SetProperty(ref.property, InstanceRef(instances[ref.target])).expect();
+    }
+
+    // Build the tree. Parents always precede their children
+    std::vector<std::shared_ptr<Instance>> roots;
+    for (uint32_t i = 0; i < instanceCount; i++) {
+        if (!instances[i]) continue;
+
+        if (parents[i] == -1)
+            roots.push_back(instances[i]);
+        else if (instances[parents[i]])
+            instances[parents[i]]->AddChild(instances[i]);
+        else
+            instances[i] = nullptr;
+    }
+
+    return roots;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Compact binary place format. XML stays the interchange format, this is
+// meant for fast saving/loading of large places.
+//
+// Layout (all integers little-endian):
+//   magic[8], u32 formatVersion, str buildVersion, str buildCommit
+//   u32 classCount,    { str className, u32 instanceCount }[]
+//   u32 propertyCount, { str propertyName }[]
+//   u32 instanceCount, { u32 classIndex, i32 parentIndex }[]  (referent table, -1 = top level)
+//   for each class:
+//     u32 chunkCount, { u32 propertyIndex, u8 valueType, value[instanceCount] }[]
+//
+// Instances are numbered in depth-first order, so a parent always precedes
+// its children, and references are stored as instance indices (-1 = null).
+// Each property chunk holds the values of every instance of its class in
+// instance order
+
+#include "error/data.h"
+#include "error/result.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Instance;
+
+#define BINARY_PLACE_MAGIC "OBLBIN\x1A\n"
+#define BINARY_PLACE_MAGIC_SIZE 8
+#define BINARY_PLACE_VERSION 1
+
+enum class BinaryValueType : uint8_t {
+    Bool = 1,
+    Int = 2,
+    Float = 3,
+    String = 4,
+    Vector3 = 5,
+    CFrame = 6,
+    Color3 = 7,
+    EnumItem = 8,
+    Ref = 9,
+};
+
+// Checks whether the file at path starts with the binary place magic
+bool isBinaryPlaceFile(std::string path);
+
+// Writes the given top-level instances (and their descendants) to path
+void saveBinaryPlace(std::vector<std::shared_ptr<Instance>> roots, std::string path);
+
+// Maps the file into memory and decodes it directly, returning the top-level
+// instances with their descendants attached
+result<std::vector<std::shared_ptr<Instance>>, PlaceParseError> loadBinaryPlace(std::string path);
@@ -20,6 +20,10 @@ void Camera::onChanged(std::string name, Variant oldValue, Variant newValue) {
     UpdateView();
 }
 
+void Camera::OnCloned() {
+    UpdateView();
+}
+
 void Camera::UpdateView() {
     // Reset zoom
     if ((cframe.Position() - focus.Position()).Magnitude() < 0.0001)
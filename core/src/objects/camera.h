@@ -13,6 +13,8 @@ class Camera : public Instance {
 
     void onChanged(std::string name, Variant oldValue, Variant newValue);
     float pitch = 0, yaw = 0;
+protected:
+    void OnCloned() override;
 public:
     enum class Mode {
         FirstPerson,
@@ -23,6 +25,8 @@ public:
     static inline std::shared_ptr<Instance> Create() { return new_instance<Camera>(); };
 
     void UpdateView();
+    inline float getPitch() { return pitch; }
+    inline float getYaw() { return yaw; }
 
     CFrame focus = CFrame(Vector3(0, 0, 0));
     CFrame cframe = CFrame(Vector3(0, 0, 0.0002));
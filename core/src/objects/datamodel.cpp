@@ -5,6 +5,8 @@
 #include "objects/base/refstate.h"
 #include "objects/base/service.h"
 #include "objects/meta.h"
+#include "objects/binaryplace.h"
+#include "objects/xmlplace.h"
 #include "objects/service/script/serverscriptservice.h"
 #include "datatypes/variant.h"
 #include "objects/service/workspace.h"
@@ -69,52 +71,51 @@ void DataModel::SaveToFile(std::optional<std::string> path) {
 
     std::string target = path.has_value() ? path.value() : this->currentFile.value();
 
-    std::ofstream outStream(target);
-    
-    pugi::xml_document doc;
-    pugi::xml_node root = doc.append_child("openblocks");
-    root.append_attribute("version").set_value(BUILD_VERSION);
-    root.append_attribute("build").set_value(BUILD_COMMIT_HASH);
+    if (target.ends_with(".oblb")) {
+        saveBinaryPlace(this->GetChildren(), target);
+    } else {
+        std::ofstream outStream(target);
+        
+        pugi::xml_document doc;
+        pugi::xml_node root = doc.append_child("openblocks");
+        root.append_attribute("version").set_value(BUILD_VERSION);
+        root.append_attribute("build").set_value(BUILD_COMMIT_HASH);
 
-    for (std::shared_ptr<Instance> child : this->GetChildren()) {
-        child->Serialize(root);
-    }
+        for (std::shared_ptr<Instance> child : this->GetChildren()) {
+            child->Serialize(root);
+        }
 
-    doc.save(outStream);
+        doc.save(outStream);
+    }
     currentFile = target;
     name = target;
     Logger::info("Place saved successfully");
 }
 
-std::shared_ptr<DataModel> DataModel::LoadFromFile(std::string path) {
-    std::ifstream inStream(path);
-    pugi::xml_document doc;
-    doc.load(inStream);
+void DataModel::addLoadedService(std::shared_ptr<Instance> service) {
+    std::string className = service->GetType().className;
 
-    pugi::xml_node rootNode = doc.child("openblocks");
-    std::shared_ptr<DataModel> newModel = new_instance<DataModel>();
-    RefStateDeserialize state = std::make_shared<__RefStateDeserialize>();
+    // TODO: Make this push its children into the first service, or however it is actually done in the thing
+    // for parity
+    if (services.count(className) != 0) {
+        Logger::fatalErrorf("Service %s defined multiple times in file", className.c_str());
+        return;
+    }
 
-    for (pugi::xml_node childNode : rootNode.children("Item")) {
-        // Make sure the class hasn't already been deserialized
-        std::string className = childNode.attribute("class").value();
+    AddChild(service);
+    services[className] = std::dynamic_pointer_cast<Service>(service);
+}
 
-        // TODO: Make this push its children into the first service, or however it is actually done in the thing
-        // for parity
-        if (newModel->services.count(className) != 0) {
-            Logger::fatalErrorf("Service %s defined multiple times in file", className.c_str());
-            continue;
-        }
+std::shared_ptr<DataModel> DataModel::LoadFromFile(std::string path, LoadProgressCallback progress) {
+    std::shared_ptr<DataModel> newModel = new_instance<DataModel>();
 
-        auto result = Instance::Deserialize(childNode, state);
-        if (result.isError()) {
-            Logger::errorf("Failed to deserialize service: %s", result.errorMessage()->c_str());
-            continue;
-        }
-        
-        auto service = result.expect();
-        newModel->AddChild(service);
-        newModel->services[className] = std::dynamic_pointer_cast<Service>(service);
+    // The binary format is decoded from a memory mapping in one go, so only XML reports progress
+    auto result = isBinaryPlaceFile(path) ? loadBinaryPlace(path) : loadXmlPlace(path, progress);
+    if (result.isError()) {
+        result.logError();
+    } else {
+        for (std::shared_ptr<Instance> service : result.expect())
+            newModel->addLoadedService(service);
     }
 
     newModel->currentFile = path;
@@ -153,51 +154,18 @@ std::shared_ptr<DataModel> DataModel::CloneModel() {
     RefStateClone state = std::make_shared<__RefStateClone>();
     std::shared_ptr<DataModel> newModel = DataModel::New();
 
-    // Copy properties
-    for (std::string property : GetProperties()) {
-        PropertyMeta meta = GetPropertyMeta(property).expect();
-        
-        if (meta.flags & (PROP_READONLY | PROP_NOSAVE)) continue;
-
-        // Update std::shared_ptr<Instance> properties using map above
-        if (meta.type.descriptor == &InstanceRef::TYPE) {
-            std::weak_ptr<Instance> refWeak = GetProperty(property).expect().get<InstanceRef>();
-            if (refWeak.expired()) continue;
-
-            auto ref = refWeak.lock();
-            auto remappedRef = state->remappedInstances[ref]; // TODO: I think this is okay? Maybe?? Add null check?
-            
-            if (remappedRef) {
-                // If the instance has already been remapped, set the new value
-                newModel->SetProperty(property, InstanceRef(remappedRef)).expect();
-            } else {
-                // Otheriise, queue this property to be updated later, and keep its current value
-                auto& refs = state->refsAwaitingRemap[ref];
-                refs.push_back(std::make_pair(newModel, property));
-                state->refsAwaitingRemap[ref] = refs;
-
-                newModel->SetProperty(property, InstanceRef(ref)).expect();
-            }
-        } else {
-            Variant value = GetProperty(property).expect();
-            newModel->SetProperty(property, value).expect();
-        }
-    }
+    cloneProperties(newModel, state);
 
-    // Remap self
-    state->remappedInstances[shared_from_this()] = newModel;
-
-    // Remap queued properties
-    for (std::pair<std::shared_ptr<Instance>, std::string> ref : state->refsAwaitingRemap[shared_from_this()]) {
-        ref.first->SetProperty(ref.second, InstanceRef(newModel)).expect();
-    }
-
-    // Clone services
+    // Clone all services before parenting any of them, so that references between
+    // them are resolved before their instances enter the new model
+    std::vector<std::pair<std::shared_ptr<Instance>, std::shared_ptr<Instance>>> clonedChildren;
     for (std::shared_ptr<Instance> child : GetChildren()) {
         auto result = child->Clone(state);
-        if (!result)
-            continue;
+        if (result)
+            clonedChildren.push_back(std::make_pair(child, result));
+    }
 
+    for (auto& [child, result] : clonedChildren) {
         newModel->AddChild(result);
 
         // Special case: Ignore instances parented to DataModel which are not services
@@ -5,6 +5,7 @@
 #include "objectmodel/macro.h"
 #include "objects/base/instance.h"
 #include "objects/base/refstate.h"
+#include "objects/xmlplace.h"
 #include <memory>
 
 class Workspace;
@@ -18,6 +19,8 @@ class DataModel : public Instance {
 private:
     // void DeserializeService(pugi::xml_node node, RefStateDeserialize);
     static void cloneService(std::shared_ptr<DataModel> target, std::shared_ptr<Service>, RefStateClone);
+    // Parents a service read from a place file, unless one of its class was already loaded
+    void addLoadedService(std::shared_ptr<Instance> service);
 public:
     std::map<std::string, std::shared_ptr<Service>> services;
 
@@ -49,7 +52,9 @@ public:
 
     // Saving/loading
     inline bool HasFile() { return this->currentFile.has_value(); }
+    // Paths ending in .oblb are saved in the binary place format, anything else as XML.
+    // Loading detects the format from the file itself
     void SaveToFile(std::optional<std::string> path = std::nullopt);
-    static std::shared_ptr<DataModel> LoadFromFile(std::string path);
+    static std::shared_ptr<DataModel> LoadFromFile(std::string path, LoadProgressCallback progress = nullptr);
     std::shared_ptr<DataModel> CloneModel();
 };
\ No newline at end of file
@@ -55,6 +55,10 @@ void JointInstance::Update() {
             oldPart0.lock()->untrackJoint(shared<JointInstance>());
         if (!oldPart1.expired())
             oldPart1.lock()->untrackJoint(shared<JointInstance>());
+
+        // The world frees the joint, so make sure it is never destroyed twice
+        joint = PhysJoint();
+        jointWorkspace.reset();
     }
 
     oldPart0 = part0;
@@ -71,14 +75,14 @@ void JointInstance::Update() {
         || workspaceOfPart(part0.lock()) != workspaceOfPart(part1.lock())
     ) return;
 
-    // TODO: Add joint continuity check here
-
     // Finally, build the joint
     buildJoint();
+    // Part1 was moved into place directly, see buildJoint
+    jointWorkspace.lock()->GetRenderScene()->markDirty(part1.lock().get());
 
     part0.lock()->trackJoint(shared<JointInstance>());
     part1.lock()->trackJoint(shared<JointInstance>());
-    jointWorkspace.lock()->TrackDrivenJoint(shared<JointInstance>());
+    if (isDrivenJoint()) jointWorkspace.lock()->TrackDrivenJoint(shared<JointInstance>());
 }
 
 nullable std::shared_ptr<Workspace> JointInstance::workspaceOfPart(std::shared_ptr<BasePart> part) {
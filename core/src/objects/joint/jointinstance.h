@@ -14,6 +14,10 @@ class JointInstance : public Instance {
 
     std::weak_ptr<BasePart> oldPart0;
     std::weak_ptr<BasePart> oldPart1;
+
+    // Position in PhysWorld::drivenJoints, or -1 if not tracked
+    int drivenJointIndex = -1;
+    friend PhysWorld;
 protected:
     // The workspace the joint was created in, if it exists
     std::weak_ptr<Workspace> jointWorkspace;
@@ -38,7 +38,9 @@ InstanceProperty def_position_property(MemberPropertyListener<BasePart> listener
         [listener](std::shared_ptr<Instance> instance, std::string name, Variant oldValue, Variant newValue) {
             auto obj = std::dynamic_pointer_cast<BasePart>(instance);
             (obj.get()->*listener)(name, oldValue, newValue);
-        }
+        },
+        // Already copied as part of CFrame
+        [](Instance*, Instance*) {}
     };
 };
 
@@ -57,7 +59,9 @@ InstanceProperty def_rotation_property(MemberPropertyListener<BasePart> listener
         [listener](std::shared_ptr<Instance> instance, std::string name, Variant oldValue, Variant newValue) {
             auto obj = std::dynamic_pointer_cast<BasePart>(instance);
             (obj.get()->*listener)(name, oldValue, newValue);
-        }
+        },
+        // Already copied as part of CFrame
+        [](Instance*, Instance*) {}
     };
 };
 
@@ -110,7 +114,9 @@ InstanceType BasePart::__buildType() {
         def_property("BackParamB", &BasePart::backParamB, 0, &BasePart::onParamUpdated),
 
         def_signal("Touched", &BasePart::Touched),
-        def_signal("TouchEnded", &BasePart::TouchEnded)
+        def_signal("TouchEnded", &BasePart::TouchEnded),
+
+        def_method("GetConnectedParts", &BasePart::GetConnectedParts)
     );
 }
 
@@ -142,11 +148,29 @@ void BasePart::OnAncestryChanged(nullable std::shared_ptr<Instance> child, nulla
 
 void BasePart::OnWorkspaceAdded(nullable std::shared_ptr<Workspace> oldWorkspace, std::shared_ptr<Workspace> newWorkspace) {
     newWorkspace->AddBody(shared<BasePart>());
+    newWorkspace->GetRenderScene()->addPart(this);
 }
 
 void BasePart::OnWorkspaceRemoved(std::shared_ptr<Workspace> oldWorkspace) {
     BreakJoints();
     oldWorkspace->RemoveBody(shared<BasePart>());
+    oldWorkspace->GetRenderScene()->removePart(this);
+}
+
+void BasePart::InternalUpdateProperty(std::string name) {
+    PVInstance::InternalUpdateProperty(name);
+
+    if (workspace() != nullptr)
+        workspace()->GetRenderScene()->markDirty(this);
+}
+
+// Only push the attributes affected by the property onto the body
+static PhysSyncFlags physSyncFlagsFor(std::string property) {
+    if (property == "Position" || property == "Rotation" || property == "CFrame") return PHYS_SYNC_TRANSFORM;
+    if (property == "Velocity" || property == "RotVelocity") return PHYS_SYNC_VELOCITY;
+    if (property == "Size" || property == "Shape") return PHYS_SYNC_SHAPE;
+    if (property == "Anchored" || property == "CanCollide") return PHYS_SYNC_MOTION;
+    return PHYS_SYNC_ALL;
 }
 
 void BasePart::onUpdated(std::string property, Variant, Variant) {
@@ -159,7 +183,7 @@ void BasePart::onUpdated(std::string property, Variant, Variant) {
     }
     
     if (workspace() != nullptr)
-        workspace()->SyncPartPhysics(std::dynamic_pointer_cast<BasePart>(this->shared_from_this()));
+        workspace()->SyncPartPhysics(std::dynamic_pointer_cast<BasePart>(this->shared_from_this()), physSyncFlagsFor(property));
 
     // When position/rotation/size is manually edited, break all joints, they don't apply anymore
     if (reset)
@@ -265,29 +289,9 @@ Vector3 BasePart::GetEffectiveSize() {
 }
 
 bool BasePart::checkJointContinuity(std::shared_ptr<BasePart> otherPart) {
-    // Make sure that the two parts don't depend on one another
-
-    return checkJointContinuityUp(otherPart) && checkJointContinuityDown(otherPart);
-}
-
-bool BasePart::checkJointContinuityDown(std::shared_ptr<BasePart> otherPart) {
-    if (shared<BasePart>() == otherPart) return false;
-    for (auto joint : primaryJoints) {
-        if (joint.expired() || joint.lock()->part1.expired()) continue;
-        if (!joint.lock()->part1.lock()->checkJointContinuityDown(otherPart))
-            return false;
-    }
-    return true;
-}
-
-bool BasePart::checkJointContinuityUp(std::shared_ptr<BasePart> otherPart) {
-    if (shared<BasePart>() == otherPart) return false;
-    for (auto joint : secondaryJoints) {
-        if (joint.expired() || joint.lock()->part0.expired()) continue;
-        if (!joint.lock()->part0.lock()->checkJointContinuityUp(otherPart))
-            return false;
-    }
-    return true;
+    // Parts that are already connected, directly or through other parts, are never joined again.
+    // Any joint between them would be redundant, or fight against the joints already there
+    return !workspace()->AreConnected(shared<BasePart>(), otherPart);
 }
 
 bool BasePart::checkSurfacesTouching(CFrame surfaceFrame, Vector3 size, Vector3 myFace, Vector3 otherFace, std::shared_ptr<BasePart> otherPart) {
@@ -328,7 +332,7 @@ nullable std::shared_ptr<JointInstance> makeJointFromSurfaces(SurfaceType a, Sur
 
 void BasePart::MakeJoints() {
     // Algorithm: Find nearby parts
-    // Make sure parts are not dependant on each other (via primary/secondaryJoints)
+    // Make sure parts are not already joined to each other (via the workspace's joint graph)
     // Find matching surfaces (surface normal dot product < -0.999)
     // Get surface cframe of this part
     // Transform surface center of other part to local via surface cframe of this part
@@ -400,63 +404,32 @@ void BasePart::MakeJoints() {
     }
 }
 
+std::vector<std::shared_ptr<Instance>> BasePart::GetConnectedParts(bool recursive) {
+    std::vector<std::shared_ptr<Instance>> parts;
+    if (!workspace()) return parts;
+
+    for (BasePart* part : workspace()->GetConnectedParts(shared<BasePart>(), recursive))
+        parts.push_back(part->shared_from_this());
+    return parts;
+}
+
 void BasePart::UpdateNoBreakJoints() {    
     if (workspace() != nullptr)
         workspace()->SyncPartPhysics(std::dynamic_pointer_cast<BasePart>(this->shared_from_this()));
 }
 
+// JointInstance::Update always untracks a joint before tracking it again, so there is no need to check for duplicates
 void BasePart::trackJoint(std::shared_ptr<JointInstance> joint) {
     if (!joint->part0.expired() && joint->part0.lock() == shared_from_this()) {
-        for (auto it = primaryJoints.begin(); it != primaryJoints.end();) {
-            // Clean expired refs
-            if (it->expired()) {
-                primaryJoints.erase(it);
-                continue;
-            }
-
-            // If the joint is already tracked, skip
-            if (it->lock() == joint)
-                return;
-            it++;
-        }
-
         primaryJoints.push_back(joint);
     } else if (!joint->part1.expired() && joint->part1.lock() == shared_from_this()) {
-        for (auto it = secondaryJoints.begin(); it != secondaryJoints.end();) {
-            // Clean expired refs
-            if (it->expired()) {
-                secondaryJoints.erase(it);
-                continue;
-            }
-
-            // If the joint is already tracked, skip
-            if (it->lock() == joint)
-                return;
-            it++;
-        }
-
         secondaryJoints.push_back(joint);
     }
 }
 
 void BasePart::untrackJoint(std::shared_ptr<JointInstance> joint) {
-    for (auto it = primaryJoints.begin(); it != primaryJoints.end();) {
-        // Clean expired refs
-        if (it->expired() || it->lock() == joint) {
-            primaryJoints.erase(it);
-            continue;
-        }
-
-        it++;
-    }
-
-    for (auto it = secondaryJoints.begin(); it != secondaryJoints.end();) {
-        // Clean expired refs
-        if (it->expired() || it->lock() == joint) {
-            secondaryJoints.erase(it);
-            continue;
-        }
-
-        it++;
-    }
+    // Clean expired refs along the way
+    auto matches = [&](const std::weak_ptr<JointInstance>& other) { return other.expired() || other.lock() == joint; };
+    std::erase_if(primaryJoints, matches);
+    std::erase_if(secondaryJoints, matches);
 }
\ No newline at end of file
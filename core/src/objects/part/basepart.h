@@ -40,8 +40,6 @@ protected:
 
     SurfaceType surfaceFromFace(NormalId);
     bool checkJointContinuity(std::shared_ptr<BasePart>);
-    bool checkJointContinuityUp(std::shared_ptr<BasePart>);
-    bool checkJointContinuityDown(std::shared_ptr<BasePart>);
     bool checkSurfacesTouching(CFrame surfaceFrame, Vector3 size, Vector3 myFace, Vector3 otherFace, std::shared_ptr<BasePart> otherPart); 
 
     friend JointInstance;
@@ -50,6 +48,7 @@ protected:
     virtual void OnWorkspaceAdded(nullable std::shared_ptr<Workspace> oldWorkspace, std::shared_ptr<Workspace> newWorkspace) override;
     virtual void OnWorkspaceRemoved(std::shared_ptr<Workspace> oldWorkspace) override;
     void OnAncestryChanged(nullable std::shared_ptr<Instance> child, nullable std::shared_ptr<Instance> newParent) override;
+    void InternalUpdateProperty(std::string name) override;
     void onUpdated(std::string, Variant, Variant);
     void onParamUpdated(std::string, Variant, Variant);
 
@@ -110,6 +109,8 @@ public:
     void MakeJoints();
     void BreakJoints();
     void UpdateNoBreakJoints();
+    // Parts joined to this one, or if recursive, every part connected to it through joints
+    std::vector<std::shared_ptr<Instance>> GetConnectedParts(bool recursive);
 
     // Calculate size of axis-aligned bounding box
     Vector3 GetAABB();
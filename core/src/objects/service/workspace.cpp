@@ -1,4 +1,5 @@
 #include "workspace.h"
+#include "common.h"
 #include "datatypes/ref.h"
 #include "objectmodel/property.h"
 #include "objectmodel/type.h"
@@ -7,7 +8,9 @@
 #include "objects/service/jointsservice.h"
 #include "objects/joint/jointinstance.h"
 #include "objects/datamodel.h"
+#include <algorithm>
 #include <memory>
+#include <optional>
 
 INSTANCE_IMPL(Workspace)
 
@@ -15,11 +18,43 @@ InstanceType Workspace::__buildType() {
     return make_instance_type<Workspace>("Workspace", INSTANCE_SERVICE | INSTANCE_NOTCREATABLE,
         set_explorer_icon("workspace"),
         def_property("FallenPartsDestroyHeight", &Workspace::fallenPartsDestroyHeight),
-        def_property("CurrentCamera", &Workspace::currentCamera)
+        def_property("CurrentCamera", &Workspace::currentCamera),
+
+        set_property_category("physics"),
+        def_property("PhysicsProfile", &Workspace::physicsProfile, 0, &Workspace::onPhysicsProfileUpdated),
+        def_property("CollisionSteps", &Workspace::collisionSteps, 0, &Workspace::onPhysicsSettingUpdated),
+        def_property("VelocityIterations", &Workspace::velocityIterations, 0, &Workspace::onPhysicsSettingUpdated),
+        def_property("PositionIterations", &Workspace::positionIterations, 0, &Workspace::onPhysicsSettingUpdated),
+        def_property("SleepThreshold", &Workspace::sleepThreshold, 0, &Workspace::onPhysicsSettingUpdated),
+        def_property("Gravity", &Workspace::gravity, 0, &Workspace::onPhysicsSettingUpdated)
     );
 }
 
-Workspace::Workspace(): physicsWorld(std::make_shared<PhysWorld>()) {
+struct PhysicsPreset {
+    int collisionSteps;
+    int velocityIterations;
+    int positionIterations;
+    float sleepThreshold;
+};
+
+static std::optional<PhysicsPreset> physicsPresetOf(PhysicsProfile profile) {
+    switch (profile) {
+    case PhysicsProfile::Fast: return PhysicsPreset { 2, 6, 1, 0.1f };
+    case PhysicsProfile::Balanced: return PhysicsPreset { 5, 10, 2, 0.03f };
+    case PhysicsProfile::Accurate: return PhysicsPreset { 10, 20, 4, 0.01f };
+    default: return std::nullopt;
+    }
+}
+
+// The physics settings are written to by each other's listeners rather than through SetProperty, so
+// changes are announced here instead
+template <typename T> static void updateSetting(std::shared_ptr<Instance> workspace, std::string property, T& field, T value) {
+    if (field == value) return;
+    field = value;
+    sendPropertyUpdatedSignal(workspace, property, Variant(value));
+}
+
+Workspace::Workspace(): physicsWorld(std::make_shared<PhysWorld>()), renderScene(std::make_shared<RenderScene>()) {
 }
 
 Workspace::~Workspace() =  default;
@@ -32,6 +67,10 @@ void Workspace::InitService() {
     // WedgePart::createWedgeShape(physicsCommon);
 }
 
+void Workspace::OnCloned() {
+    applyPhysicsSettings();
+}
+
 void Workspace::OnRun() {
     // Make joints
     for (auto&& it : this->GetDescendants()) {
@@ -54,23 +93,74 @@ void Workspace::OnRun() {
     }
 }
 
-void Workspace::SyncPartPhysics(std::shared_ptr<BasePart> part) {
-    physicsWorld->syncBodyProperties(part);
+void Workspace::SyncPartPhysics(std::shared_ptr<BasePart> part, PhysSyncFlags flags) {
+    physicsWorld->syncBodyProperties(part, flags);
+}
+
+void Workspace::onPhysicsProfileUpdated(std::string property, Variant, Variant) {
+    std::optional<PhysicsPreset> preset = physicsPresetOf(physicsProfile);
+    if (preset) {
+        updateSetting(shared_from_this(), "CollisionSteps", collisionSteps, preset->collisionSteps);
+        updateSetting(shared_from_this(), "VelocityIterations", velocityIterations, preset->velocityIterations);
+        updateSetting(shared_from_this(), "PositionIterations", positionIterations, preset->positionIterations);
+        updateSetting(shared_from_this(), "SleepThreshold", sleepThreshold, preset->sleepThreshold);
+    }
+
+    applyPhysicsSettings();
+}
+
+void Workspace::onPhysicsSettingUpdated(std::string property, Variant, Variant) {
+    // Gravity is independent from the profile
+    std::optional<PhysicsPreset> preset = physicsPresetOf(physicsProfile);
+    if (preset && property != "Gravity") {
+        bool matchesPreset = collisionSteps == preset->collisionSteps
+                          && velocityIterations == preset->velocityIterations
+                          && positionIterations == preset->positionIterations
+                          && sleepThreshold == preset->sleepThreshold;
+        if (!matchesPreset)
+            updateSetting(shared_from_this(), "PhysicsProfile", physicsProfile, PhysicsProfile::Custom);
+    }
+
+    applyPhysicsSettings();
+}
+
+void Workspace::applyPhysicsSettings() {
+    // Sanitize values, the solver needs at least one of each
+    updateSetting(shared_from_this(), "CollisionSteps", collisionSteps, std::max(collisionSteps, 1));
+    updateSetting(shared_from_this(), "VelocityIterations", velocityIterations, std::max(velocityIterations, 1));
+    updateSetting(shared_from_this(), "PositionIterations", positionIterations, std::max(positionIterations, 1));
+    updateSetting(shared_from_this(), "SleepThreshold", sleepThreshold, std::max(sleepThreshold, 0.f));
+
+    physicsWorld->setSimulationSettings(PhysSimulationSettings {
+        .collisionSteps = collisionSteps,
+        .velocityIterations = velocityIterations,
+        .positionIterations = positionIterations,
+        .sleepThreshold = sleepThreshold,
+        .gravity = gravity,
+    });
 }
 
 void Workspace::PhysicsStep(float deltaTime) {
-    physicsWorld->step(deltaTime);
+    physicsWorld->step(deltaTime, fallenPartsDestroyHeight);
 
-    for (std::shared_ptr<BasePart> part : physicsWorld->getSimulatedBodies()) {
-        // Destroy fallen parts
-        if (part->cframe.Position().Y() < this->fallenPartsDestroyHeight) {
-            auto parent = part->GetParent();
-            part->Destroy();
+    // The simulation writes back transforms without going through SetProperty
+    for (BasePart* part : physicsWorld->getMovedParts())
+        renderScene->markDirty(part);
 
-            // If the parent of the part is a Model, destroy it too
-            if (parent != nullptr && parent->IsA("Model"))
-                parent->Destroy();
-        }
+    std::vector<std::shared_ptr<BasePart>> fallenParts = physicsWorld->takeFallenParts();
+    if (fallenParts.empty()) return;
+
+    // Take all the bodies out at once, so that destroying the parts below doesn't remove them one by one
+    physicsWorld->removeBodies(fallenParts);
+
+    for (std::shared_ptr<BasePart> part : fallenParts) {
+        auto parent = part->GetParent();
+        if (parent == nullptr) continue; // Already destroyed along with its model
+        part->Destroy();
+
+        // If the parent of the part is a Model, destroy it too
+        if (parent->IsA("Model"))
+            parent->Destroy();
     }
 }
 
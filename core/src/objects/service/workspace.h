@@ -4,10 +4,12 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include "enum/physics.h"
 #include "objectmodel/macro.h"
 #include "objects/base/service.h"
 #include "physics/world.h"
 #include "rendering/frustum.h"
+#include "rendering/renderscene.h"
 #include "objects/camera.h"
 
 class BasePart;
@@ -32,10 +34,16 @@ class Workspace : public Service {
     std::mutex contactQueueLock;
 
     std::shared_ptr<PhysWorld> physicsWorld;
+    std::shared_ptr<RenderScene> renderScene;
     friend PhysWorld;
 protected:
     bool initialized = false;
 
+    void onPhysicsProfileUpdated(std::string property, Variant, Variant);
+    void onPhysicsSettingUpdated(std::string property, Variant, Variant);
+    void applyPhysicsSettings();
+    void OnCloned() override;
+
 public:
     Workspace();
     ~Workspace();
@@ -48,6 +56,15 @@ public:
     float fallenPartsDestroyHeight = -500;
     std::weak_ptr<Camera> currentCamera;
 
+    // Setting a profile overwrites the values below with its preset. Editing
+    // any of them afterwards switches the profile to Custom
+    PhysicsProfile physicsProfile = PhysicsProfile::Balanced;
+    int collisionSteps = 5;
+    int velocityIterations = 10;
+    int positionIterations = 2;
+    float sleepThreshold = 0.03f;
+    float gravity = 196.f;
+
     std::shared_ptr<Camera> GetCamera();
 
     // static inline std::shared_ptr<Workspace> New() { return new_instance<Workspace>(); };
@@ -55,7 +72,7 @@ public:
 
     inline void AddBody(std::shared_ptr<BasePart> part) { physicsWorld->addBody(part); }
     inline void RemoveBody(std::shared_ptr<BasePart> part) { physicsWorld->removeBody(part); }
-    void SyncPartPhysics(std::shared_ptr<BasePart> part);
+    void SyncPartPhysics(std::shared_ptr<BasePart> part, PhysSyncFlags flags = PHYS_SYNC_ALL);
 
     inline PhysJoint CreateJoint(PhysJointInfo& info, std::shared_ptr<BasePart> part0, std::shared_ptr<BasePart> part1) { return physicsWorld->createJoint(info, part0, part1); }
     inline void DestroyJoint(PhysJoint joint) { physicsWorld->destroyJoint(joint); }
@@ -63,7 +80,19 @@ public:
     inline void TrackDrivenJoint(std::shared_ptr<JointInstance> motor) { return physicsWorld->trackDrivenJoint(motor); }
     inline void UntrackDrivenJoint(std::shared_ptr<JointInstance> motor) { return physicsWorld->untrackDrivenJoint(motor); }
 
+    // Connectivity of the joints built in the physics world
+    inline bool AreJoined(std::shared_ptr<BasePart> a, std::shared_ptr<BasePart> b) { return physicsWorld->getJointGraph().areJoined(a.get(), b.get()); }
+    inline bool AreConnected(std::shared_ptr<BasePart> a, std::shared_ptr<BasePart> b) { return physicsWorld->getJointGraph().areConnected(a.get(), b.get()); }
+    inline bool AreRigidlyConnected(std::shared_ptr<BasePart> a, std::shared_ptr<BasePart> b) { return physicsWorld->getJointGraph().areRigidlyConnected(a.get(), b.get()); }
+    inline std::vector<BasePart*> GetConnectedParts(std::shared_ptr<BasePart> part, bool recursive) { return physicsWorld->getJointGraph().connectedParts(part.get(), recursive); }
+
+    inline std::shared_ptr<RenderScene> GetRenderScene() { return renderScene; }
+
     void PhysicsStep(float deltaTime);
-    inline std::optional<const RaycastResult> CastRayNearest(glm::vec3 point, glm::vec3 rotation, float maxLength, std::optional<RaycastFilter> filter = std::nullopt, unsigned short categoryMaskBits = 0xFFFF) { return physicsWorld->castRay(point, rotation, maxLength, filter, categoryMaskBits); }
+    inline std::optional<const RaycastResult> CastRayNearest(glm::vec3 point, glm::vec3 rotation, float maxLength, std::optional<RaycastFilter> filter = std::nullopt, unsigned short categoryMaskBits = 0xFFFF) { return physicsWorld->castRay(point, rotation, maxLength, PhysQueryParams { .filter = filter, .categoryMaskBits = categoryMaskBits }); }
+    inline std::optional<const RaycastResult> CastRayNearest(glm::vec3 point, glm::vec3 rotation, float maxLength, const PhysQueryParams& params) { return physicsWorld->castRay(point, rotation, maxLength, params); }
+    inline std::vector<std::optional<RaycastResult>> CastRays(const std::vector<PhysRay>& rays, const PhysQueryParams& params = {}) { return physicsWorld->castRays(rays, params); }
+    inline std::vector<std::optional<RaycastResult>> CastSpheres(const std::vector<PhysRay>& casts, float radius, const PhysQueryParams& params = {}) { return physicsWorld->castSpheres(casts, radius, params); }
+    inline std::vector<std::optional<RaycastResult>> CastBoxes(const std::vector<PhysRay>& casts, Vector3 size, CFrame rotation, const PhysQueryParams& params = {}) { return physicsWorld->castBoxes(casts, size, rotation, params); }
     std::vector<std::shared_ptr<Instance>> CastFrustum(Frustum frustum);
 };
\ No newline at end of file
@@ -0,0 +1,523 @@
+#include "xmlplace.h"
+#include "error/instance.h"
+#include "objects/base/instance.h"
+#include "objects/base/refstate.h"
+#include "objects/meta.h"
+#include "common.h"
+#include "logger.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <mutex>
+#include <pugixml.hpp>
+#include <thread>
+
+#define XML_READ_CHUNK_SIZE (64 * 1024)
+// Amount of captured subtree source handed to a worker at once
+#define XML_JOB_BATCH_SIZE (256 * 1024)
+// Jobs waiting for a worker, per worker, before the reader waits for them to catch up
+#define XML_JOB_QUEUE_DEPTH 4
+
+struct XmlTag {
+    std::string name;
+    std::map<std::string, std::string> attributes;
+    bool closing = false;
+    bool selfClosing = false;
+};
+
+static std::string decodeEntities(const std::string& str) {
+    static const std::pair<const char*, char> entities[] = {
+        { "&lt;", '<' }, { "&gt;", '>' }, { "&amp;", '&' }, { "&quot;", '"' }, { "&apos;", '\'' },
+    };
+
+    if (str.find('&') == std::string::npos) return str;
+
+    std::string decoded;
+    for (size_t i = 0; i < str.size(); i++) {
+        bool replaced = false;
+        if (str[i] == '&') {
+            for (auto& [entity, c] : entities) {
+                if (str.compare(i, strlen(entity), entity) == 0) {
+                    decoded += c;
+                    i += strlen(entity) - 1;
+                    replaced = true;
+                    break;
+                }
+            }
+        }
+        if (!replaced) decoded += str[i];
+    }
+    return decoded;
+}
+
+// Incremental tag scanner over a file. Consumed input is dropped from the
+// buffer whenever more is read, so only the unread tail is kept in memory
+class XmlPlaceStream {
+    std::ifstream stream;
+    std::string buffer;
+    size_t pos = 0;
+    size_t bufferStart = 0; // Offset of the start of the buffer within the file
+    size_t lastTagStart = 0;
+    std::optional<size_t> captureStart;
+    size_t bytesRead = 0;
+    size_t totalBytes = 0;
+    LoadProgressCallback progress;
+
+    bool fill();
+    bool ensure(size_t count);
+    bool startsWithAt(size_t offset, const char* str);
+    // Offsets are relative to the current position, since reading more input moves the buffer
+    size_t find(const char* needle, size_t offset = 0);
+    bool skipPast(const char* terminator);
+    bool readTag(XmlTag& tag);
+public:
+    XmlPlaceStream(std::string path, LoadProgressCallback progress);
+
+    inline bool isOpen() { return stream.is_open(); }
+
+    // Reads the next start or end tag, skipping text, comments and declarations
+    bool nextTag(XmlTag& tag);
+    // Skips the rest of an element whose start tag was just read
+    bool skipElement();
+    // Reads the raw contents of an element whose start tag was just read, up to its closing tag
+    bool readContent(const std::string& tagName, std::string& content);
+    // Reads the source of a whole element whose start tag was just read, including that tag
+    bool captureElement(const XmlTag& tag, std::string& source);
+};
+
+XmlPlaceStream::XmlPlaceStream(std::string path, LoadProgressCallback progress) : stream(path, std::ios::binary), progress(progress) {
+    std::error_code err;
+    totalBytes = std::filesystem::file_size(path, err);
+    if (err) totalBytes = 0;
+}
+
+bool XmlPlaceStream::fill() {
+    if (!stream) return false;
+
+    // Drop everything that has already been consumed, unless it is being captured
+    size_t consumed = pos;
+    if (captureStart) consumed = std::min(consumed, captureStart.value() - bufferStart);
+    buffer.erase(0, consumed);
+    pos -= consumed;
+    bufferStart += consumed;
+
+    size_t oldSize = buffer.size();
+    buffer.resize(oldSize + XML_READ_CHUNK_SIZE);
+    stream.read(buffer.data() + oldSize, XML_READ_CHUNK_SIZE);
+    size_t count = stream.gcount();
+    buffer.resize(oldSize + count);
+
+    bytesRead += count;
+    if (progress) progress(bytesRead, totalBytes);
+    return count > 0;
+}
+
+bool XmlPlaceStream::ensure(size_t count) {
+    while (buffer.size() - pos < count) {
+        if (!fill()) return false;
+    }
+    return true;
+}
+
+bool XmlPlaceStream::startsWithAt(size_t offset, const char* str) {
+    size_t length = strlen(str);
+    return ensure(offset + length) && buffer.compare(pos + offset, length, str) == 0;
+}
+
+size_t XmlPlaceStream::find(const char* needle, size_t offset) {
+    size_t length = strlen(needle);
+    while (true) {
+        size_t found = buffer.find(needle, pos + offset);
+        if (found != std::string::npos) return found - pos;
+
+        // The needle may still straddle the end of what has been read so far
+        size_t scanned = buffer.size() - pos;
+        if (scanned >= length) offset = std::max(offset, scanned - length + 1);
+        if (!fill()) return std::string::npos;
+    }
+}
+
+bool XmlPlaceStream::skipPast(const char* terminator) {
+    size_t found = find(terminator);
+    if (found == std::string::npos) return false;
+    pos += found + strlen(terminator);
+    return true;
+}
+
+bool XmlPlaceStream::nextTag(XmlTag& tag) {
+    while (true) {
+        size_t found = find("<");
+        if (found == std::string::npos) return false;
+        pos += found;
+
+        if (startsWithAt(0, "<?")) {
+            if (!skipPast("?>")) return false;
+        } else if (startsWithAt(0, "<!--")) {
+            if (!skipPast("-->")) return false;
+        } else if (startsWithAt(0, "<![CDATA[")) {
+            if (!skipPast("]]>")) return false;
+        } else if (startsWithAt(0, "<!")) {
+            if (!skipPast(">")) return false;
+        } else {
+            return readTag(tag);
+        }
+    }
+}
+
+bool XmlPlaceStream::readTag(XmlTag& tag) {
+    lastTagStart = bufferStart + pos;
+
+    // Find the end of the tag, ignoring any '>' within attribute values
+    size_t end = 1;
+    char quote = 0;
+    while (true) {
+        if (!ensure(end + 1)) return false;
+        char c = buffer[pos + end];
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            break;
+        }
+        end++;
+    }
+
+    std::string text = buffer.substr(pos + 1, end - 1);
+    pos += end + 1;
+
+    tag = XmlTag();
+    if (!text.empty() && text[0] == '/') {
+        tag.closing = true;
+        text.erase(0, 1);
+    }
+    if (!text.empty() && text.back() == '/') {
+        tag.selfClosing = true;
+        text.pop_back();
+    }
+
+    const char* whitespace = " \t\r\n";
+    size_t i = text.find_first_of(whitespace);
+    tag.name = text.substr(0, i);
+
+    // Attributes
+    while (i != std::string::npos && i < text.size()) {
+        i = text.find_first_not_of(whitespace, i);
+        if (i == std::string::npos) break;
+
+        size_t eq = text.find('=', i);
+        if (eq == std::string::npos || eq == i) break;
+        std::string name = text.substr(i, text.find_last_not_of(whitespace, eq - 1) - i + 1);
+
+        size_t open = text.find_first_of("\"'", eq);
+        if (open == std::string::npos) break;
+        size_t close = text.find(text[open], open + 1);
+        if (close == std::string::npos) break;
+
+        tag.attributes[name] = decodeEntities(text.substr(open + 1, close - open - 1));
+        i = close + 1;
+    }
+
+    return true;
+}
+
+bool XmlPlaceStream::skipElement() {
+    XmlTag tag;
+    int depth = 1;
+    while (depth > 0) {
+        if (!nextTag(tag)) return false;
+        if (tag.closing) depth--;
+        else if (!tag.selfClosing) depth++;
+    }
+    return true;
+}
+
+bool XmlPlaceStream::readContent(const std::string& tagName, std::string& content) {
+    std::string closingTag = "</" + tagName + ">";
+    size_t offset = 0;
+
+    while (true) {
+        size_t found = find("<", offset);
+        if (found == std::string::npos) return false;
+
+        // The closing tag could appear in a CDATA section or comment, so skip over those
+        if (startsWithAt(found, "<![CDATA[")) {
+            size_t end = find("]]>", found);
+            if (end == std::string::npos) return false;
+            offset = end + 3;
+        } else if (startsWithAt(found, "<!--")) {
+            size_t end = find("-->", found);
+            if (end == std::string::npos) return false;
+            offset = end + 3;
+        } else if (startsWithAt(found, closingTag.c_str())) {
+            content.assign(buffer, pos, found);
+            pos += found + closingTag.size();
+            return true;
+        } else {
+            offset = found + 1;
+        }
+    }
+}
+
+bool XmlPlaceStream::captureElement(const XmlTag& tag, std::string& source) {
+    captureStart = lastTagStart;
+    bool complete = tag.selfClosing || skipElement();
+    size_t start = captureStart.value() - bufferStart;
+    captureStart = std::nullopt;
+
+    if (!complete) return false;
+    source.assign(buffer, start, pos - start);
+    return true;
+}
+
+// A batch of sibling subtrees, parsed and constructed into detached trees on a
+// worker thread. Anything the workers log is kept for the main thread, and
+// references are resolved on the main thread too, once every job is done
+struct SubtreeJob {
+    std::vector<std::string> sources;
+    std::vector<std::shared_ptr<Instance>> parents;
+    size_t size = 0;
+
+    std::vector<nullable std::shared_ptr<Instance>> subtrees;
+    RefStateDeserialize state = std::make_shared<__RefStateDeserialize>();
+    std::vector<Logger::DeferredMessage> messages;
+};
+
+static void runSubtreeJob(SubtreeJob& job) {
+    isDetachedBuildThread = true;
+    Logger::deferThreadMessages(&job.messages);
+
+    for (std::string& source : job.sources) {
+        pugi::xml_document doc;
+        pugi::xml_parse_result parsed = doc.load_buffer(source.data(), source.size(), pugi::parse_default, pugi::encoding_utf8);
+        // Release the source as soon as it has been parsed
+        source = std::string();
+
+        if (!parsed) {
+            Logger::errorf("Failed to parse item: %s", parsed.description());
+            job.subtrees.push_back(nullptr);
+            continue;
+        }
+
+        auto result = Instance::Deserialize(doc.child("Item"), job.state);
+        if (result.isError()) {
+            result.logError();
+            job.subtrees.push_back(nullptr);
+            continue;
+        }
+        job.subtrees.push_back(result.expect());
+    }
+
+    Logger::deferThreadMessages(nullptr);
+    isDetachedBuildThread = false;
+}
+
+class SubtreeJobPool {
+    std::vector<std::thread> workers;
+    std::deque<SubtreeJob*> queue;
+    std::mutex queueLock;
+    std::condition_variable jobQueued;
+    std::condition_variable jobTaken;
+    bool finishing = false;
+
+    void workerLoop();
+public:
+    SubtreeJobPool();
+    ~SubtreeJobPool();
+
+    // Queues the job, or runs it right away if there are no workers
+    void submit(SubtreeJob* job);
+    // Waits for all queued jobs to be done
+    void finish();
+};
+
+SubtreeJobPool::SubtreeJobPool() {
+    // The reader itself keeps the calling thread busy
+    unsigned int count = std::thread::hardware_concurrency();
+    for (unsigned int i = 1; i < count; i++)
+        workers.emplace_back(&SubtreeJobPool::workerLoop, this);
+}
+
+SubtreeJobPool::~SubtreeJobPool() {
+    finish();
+}
+
+void SubtreeJobPool::workerLoop() {
+    while (true) {
+        std::unique_lock lock(queueLock);
+        jobQueued.wait(lock, [&]() { return !queue.empty() || finishing; });
+        if (queue.empty()) return;
+
+        SubtreeJob* job = queue.front();
+        queue.pop_front();
+        lock.unlock();
+        jobTaken.notify_one();
+
+        runSubtreeJob(*job);
+    }
+}
+
+void SubtreeJobPool::submit(SubtreeJob* job) {
+    if (workers.empty()) {
+        runSubtreeJob(*job);
+        return;
+    }
+
+    // Don't let captured sources pile up faster than they are processed
+    std::unique_lock lock(queueLock);
+    jobTaken.wait(lock, [&]() { return queue.size() < workers.size() * XML_JOB_QUEUE_DEPTH; });
+    queue.push_back(job);
+    lock.unlock();
+    jobQueued.notify_one();
+}
+
+void SubtreeJobPool::finish() {
+    {
+        std::lock_guard lock(queueLock);
+        finishing = true;
+    }
+    jobQueued.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+// Attaches the subtrees built by the jobs in file order, and resolves every
+// reference that could not be resolved within a single job
+static void finishSubtreeJobs(std::vector<std::unique_ptr<SubtreeJob>>& jobs, RefStateDeserialize state) {
+    for (auto& job : jobs) {
+        for (Logger::DeferredMessage& message : job->messages)
+            Logger::log(message.message, message.logLevel);
+
+        for (size_t i = 0; i < job->subtrees.size(); i++) {
+            if (job->subtrees[i])
+                job->parents[i]->AddChild(job->subtrees[i]);
+        }
+    }
+
+    // Register every instance first, which also resolves references from the main thread's items
+    for (auto& job : jobs) {
+        for (auto& [referent, instance] : job->state->remappedInstances) {
+            // Lookups must not leave empty entries behind, but don't trust that
+            if (!instance) continue;
+            instance->DeserializeReferent(referent, state);
+        }
+    }
+
+    for (auto& job : jobs) {
+        for (auto& [referent, refs] : job->state->refsAwaitingRemap) {
+            std::shared_ptr<Instance>* target = state->remappedInstances.find(referent);
+            if (!target) continue;
+
+            for (auto& [instance, property] : refs)
+                instance->SetProperty(property, InstanceRef(*target)).expect();
+        }
+    }
+}
+
+result<std::vector<std::shared_ptr<Instance>>, PlaceParseError> loadXmlPlace(std::string path, LoadProgressCallback progress) {
+    XmlPlaceStream stream(path, progress);
+    if (!stream.isOpen())
+        return PlaceParseError("Could not open file '" + path + "'");
+
+    RefStateDeserialize state = std::make_shared<__RefStateDeserialize>();
+    std::vector<std::shared_ptr<Instance>> roots;
+    // Items whose start tag was read, but not yet their end tag
+    std::vector<std::shared_ptr<Instance>> openItems;
+
+    std::vector<std::unique_ptr<SubtreeJob>> jobs;
+    std::unique_ptr<SubtreeJob> pendingJob;
+    // Declared last, so that workers are joined before the jobs are freed on early returns
+    SubtreeJobPool pool;
+
+    XmlTag tag;
+    if (!stream.nextTag(tag) || tag.closing || tag.name != "openblocks")
+        return PlaceParseError("Missing <openblocks> root element");
+    if (tag.selfClosing)
+        return roots;
+
+    while (stream.nextTag(tag)) {
+        if (tag.closing) {
+            if (tag.name == "openblocks" && openItems.empty()) {
+                if (pendingJob) {
+                    pool.submit(pendingJob.get());
+                    jobs.push_back(std::move(pendingJob));
+                }
+                pool.finish();
+
+                finishSubtreeJobs(jobs, state);
+                return roots;
+            }
+            if (tag.name != "Item" || openItems.empty())
+                return PlaceParseError("Unexpected </" + tag.name + ">");
+
+            std::shared_ptr<Instance> item = openItems.back();
+            openItems.pop_back();
+            if (openItems.empty())
+                roots.push_back(item);
+            else
+                openItems.back()->AddChild(item);
+            continue;
+        }
+
+        if (tag.name == "Item" && openItems.size() == 1) {
+            // The children of services are independent subtrees, so they are built on worker threads
+            if (!pendingJob) pendingJob = std::make_unique<SubtreeJob>();
+
+            std::string source;
+            if (!stream.captureElement(tag, source)) break;
+            pendingJob->size += source.size();
+            pendingJob->sources.push_back(std::move(source));
+            pendingJob->parents.push_back(openItems.back());
+
+            if (pendingJob->size >= XML_JOB_BATCH_SIZE) {
+                pool.submit(pendingJob.get());
+                jobs.push_back(std::move(pendingJob));
+            }
+        } else if (tag.name == "Item") {
+            std::string className = tag.attributes["class"];
+            if (INSTANCE_MAP.count(className) == 0 || !INSTANCE_MAP[className]->constructor.has_value()) {
+                NoSuchInstance(className).logMessage();
+                if (!tag.selfClosing && !stream.skipElement()) break;
+                continue;
+            }
+
+            std::shared_ptr<Instance> object = INSTANCE_MAP[className]->constructor.value()();
+            object->DeserializeReferent(tag.attributes["referent"], state);
+
+            if (!tag.selfClosing)
+                openItems.push_back(object);
+            else if (openItems.empty())
+                roots.push_back(object);
+            else
+                openItems.back()->AddChild(object);
+        } else if (tag.name == "Properties" && !openItems.empty()) {
+            if (tag.selfClosing) continue;
+
+            std::string content;
+            if (!stream.readContent(tag.name, content)) break;
+
+            // Only this item's properties are parsed into a document
+            pugi::xml_document fragment;
+            pugi::xml_parse_result parsed = fragment.load_buffer(content.data(), content.size(), pugi::parse_default | pugi::parse_fragment);
+            if (!parsed) {
+                Logger::errorf("Failed to parse properties of %s: %s", openItems.back()->GetType().className.c_str(), parsed.description());
+                continue;
+            }
+
+            openItems.back()->DeserializeProperties(fragment, state);
+        } else if (!tag.selfClosing) {
+            // Unknown element, e.g. rbxl metadata
+            if (!stream.skipElement()) break;
+        }
+    }
+
+    return PlaceParseError("Unexpected end of file");
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Streaming reader for XML place files. Rather than loading the whole file
+// into a pugixml document, the file is read in chunks and scanned for tags,
+// and services are constructed as their <Item> tags are reached, with only
+// their <Properties> block parsed into a (small) document.
+//
+// The children of services are independent subtrees, so their source is
+// captured and handed to a pool of worker threads in batches, which parse
+// and construct them into detached trees. Once the whole file has been read,
+// the main thread attaches those trees and resolves the references between them
+
+#include "error/data.h"
+#include "error/result.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Instance;
+
+// Called as the file is read, with the number of bytes read so far and the total size of the file
+typedef std::function<void(size_t bytesRead, size_t totalBytes)> LoadProgressCallback;
+
+// Reads the file at path, returning its top-level instances with their descendants attached
+result<std::vector<std::shared_ptr<Instance>>, PlaceParseError> loadXmlPlace(std::string path, LoadProgressCallback progress = nullptr);
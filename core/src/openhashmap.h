@@ -0,0 +1,118 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Hash map using open addressing with linear probing, storing its entries in
+// a single flat array. Meant for short-lived lookup tables with cheap keys
+// (pointers, integers) where std::map's per-node allocations dominate.
+// Keys and values must be default constructible. Pointers to values are
+// invalidated by inserting into the map
+template <typename K, typename V, typename Hash = std::hash<K>>
+class OpenHashMap {
+    std::vector<std::pair<K, V>> entries;
+    std::vector<uint8_t> occupied;
+    size_t _size = 0;
+    int shift = 64;
+
+    // Hashes such as std::hash on pointers are often the identity, so spread
+    // the bits out before taking the top ones as the slot index
+    inline size_t slotOf(const K& key) const {
+        return (size_t)(((uint64_t)Hash{}(key) * 11400714819323198485ull) >> shift);
+    }
+
+    inline size_t mask() const { return entries.size() - 1; }
+
+    void grow() {
+        std::vector<std::pair<K, V>> oldEntries = std::move(entries);
+        std::vector<uint8_t> oldOccupied = std::move(occupied);
+
+        size_t capacity = oldEntries.empty() ? 16 : oldEntries.size() * 2;
+        entries = std::vector<std::pair<K, V>>(capacity);
+        occupied = std::vector<uint8_t>(capacity, 0);
+        shift = 64 - std::countr_zero(capacity);
+        _size = 0;
+
+        for (size_t i = 0; i < oldEntries.size(); i++) {
+            if (oldOccupied[i])
+                insertNew(std::move(oldEntries[i].first), std::move(oldEntries[i].second));
+        }
+    }
+
+    V& insertNew(K key, V value) {
+        size_t slot = slotOf(key);
+        while (occupied[slot]) slot = (slot + 1) & mask();
+
+        occupied[slot] = 1;
+        entries[slot] = std::make_pair(std::move(key), std::move(value));
+        _size++;
+        return entries[slot].second;
+    }
+
+    size_t findSlot(const K& key) const {
+        if (_size == 0) return SIZE_MAX;
+        for (size_t slot = slotOf(key); occupied[slot]; slot = (slot + 1) & mask()) {
+            if (entries[slot].first == key) return slot;
+        }
+        return SIZE_MAX;
+    }
+
+public:
+    class iterator {
+        OpenHashMap* map;
+        size_t slot;
+
+        void skipEmpty() { while (slot < map->entries.size() && !map->occupied[slot]) slot++; }
+    public:
+        iterator(OpenHashMap* map, size_t slot) : map(map), slot(slot) { skipEmpty(); }
+
+        inline std::pair<K, V>& operator*() const { return map->entries[slot]; }
+        inline std::pair<K, V>* operator->() const { return &map->entries[slot]; }
+        inline iterator& operator++() { slot++; skipEmpty(); return *this; }
+        inline bool operator==(const iterator& other) const { return slot == other.slot; }
+    };
+
+    inline iterator begin() { return iterator(this, 0); }
+    inline iterator end() { return iterator(this, entries.size()); }
+    inline size_t size() const { return _size; }
+
+    // Returns the value for the key, or nullptr if there is none
+    V* find(const K& key) {
+        size_t slot = findSlot(key);
+        return slot == SIZE_MAX ? nullptr : &entries[slot].second;
+    }
+
+    // Returns the value for the key, inserting a default one if there is none
+    V& operator[](const K& key) {
+        if (V* value = find(key)) return *value;
+
+        // Keep the load factor under 3/4
+        if ((_size + 1) * 4 > entries.size() * 3) grow();
+        return insertNew(key, V());
+    }
+
+    void erase(const K& key) {
+        size_t slot = findSlot(key);
+        if (slot == SIZE_MAX) return;
+
+        // Shift following entries of the probe sequence back, so that no
+        // tombstones are needed
+        size_t hole = slot;
+        for (size_t next = (hole + 1) & mask(); occupied[next]; next = (next + 1) & mask()) {
+            size_t home = slotOf(entries[next].first);
+            // Move the entry if its home slot isn't between the hole and its current slot
+            if (((next - home) & mask()) >= ((next - hole) & mask())) {
+                entries[hole] = std::move(entries[next]);
+                hole = next;
+            }
+        }
+
+        entries[hole] = std::pair<K, V>();
+        occupied[hole] = 0;
+        _size--;
+    }
+};
@@ -32,6 +32,7 @@ public:
     inline Vector3 bounds() { return _bounds; };
     inline Vector3 size() { return _size; };
     inline bool multipleSelected() { return parts.size() > 1; }
+    inline const std::vector<std::shared_ptr<BasePart>>& GetParts() { return parts; }
 
     // Gets the current transform state of all the parts in the assembly
     std::vector<PartTransformState> GetCurrentTransforms();
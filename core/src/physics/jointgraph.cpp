@@ -0,0 +1,142 @@
+#include "jointgraph.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+BasePart* JointGraph::DisjointSets::find(BasePart* part) {
+    if (!nodes.contains(part)) return part;
+
+    // Path halving
+    BasePart* current = part;
+    while (nodes[current].parent != current) {
+        Node& node = nodes[current];
+        node.parent = nodes[node.parent].parent;
+        current = node.parent;
+    }
+    return current;
+}
+
+void JointGraph::DisjointSets::unite(BasePart* a, BasePart* b) {
+    nodes.try_emplace(a, Node { a, 1 });
+    nodes.try_emplace(b, Node { b, 1 });
+
+    BasePart* rootA = find(a);
+    BasePart* rootB = find(b);
+    if (rootA == rootB) return;
+
+    // Union by size
+    if (nodes[rootA].size < nodes[rootB].size) std::swap(rootA, rootB);
+    nodes[rootB].parent = rootA;
+    nodes[rootA].size += nodes[rootB].size;
+}
+
+void JointGraph::rebuild(DisjointSets& sets, bool rigidOnly) {
+    sets.nodes.clear();
+    for (auto& [joint, edge] : edges) {
+        if (edge.rigid || !rigidOnly) sets.unite(edge.part0, edge.part1);
+    }
+    sets.dirty = false;
+}
+
+void JointGraph::addJoint(PhysJointRecord* joint, BasePart* part0, BasePart* part1, bool rigid) {
+    if (edges.contains(joint)) removeJoint(joint);
+
+    edges[joint] = Edge { part0, part1, rigid };
+    adjacency[part0].push_back(joint);
+    if (part1 != part0) adjacency[part1].push_back(joint);
+
+    // Joining sets never splits them, so they can be updated in place
+    if (rigid && !rigidSets.dirty) rigidSets.unite(part0, part1);
+    if (!connectedSets.dirty) connectedSets.unite(part0, part1);
+}
+
+void JointGraph::removeJoint(PhysJointRecord* joint) {
+    auto it = edges.find(joint);
+    if (it == edges.end()) return;
+    Edge edge = it->second;
+    edges.erase(it);
+
+    for (BasePart* part : { edge.part0, edge.part1 }) {
+        auto adjacent = adjacency.find(part);
+        if (adjacent == adjacency.end()) continue;
+        std::erase(adjacent->second, joint);
+        if (adjacent->second.empty()) adjacency.erase(adjacent);
+    }
+
+    if (edge.rigid) rigidSets.dirty = true;
+    connectedSets.dirty = true;
+}
+
+void JointGraph::setRigid(PhysJointRecord* joint, bool rigid) {
+    auto it = edges.find(joint);
+    if (it == edges.end() || it->second.rigid == rigid) return;
+    it->second.rigid = rigid;
+
+    if (!rigid) rigidSets.dirty = true;
+    else if (!rigidSets.dirty) rigidSets.unite(it->second.part0, it->second.part1);
+}
+
+bool JointGraph::areJoined(BasePart* a, BasePart* b) {
+    auto it = adjacency.find(a);
+    if (it == adjacency.end()) return false;
+
+    for (PhysJointRecord* joint : it->second) {
+        const Edge& edge = edges[joint];
+        if ((edge.part0 == a && edge.part1 == b) || (edge.part0 == b && edge.part1 == a))
+            return true;
+    }
+    return false;
+}
+
+bool JointGraph::areRigidlyConnected(BasePart* a, BasePart* b) {
+    if (rigidSets.dirty) rebuild(rigidSets, true);
+    return rigidSets.find(a) == rigidSets.find(b);
+}
+
+bool JointGraph::areConnected(BasePart* a, BasePart* b) {
+    if (connectedSets.dirty) rebuild(connectedSets, false);
+    return connectedSets.find(a) == connectedSets.find(b);
+}
+
+std::vector<BasePart*> JointGraph::rigidComponent(BasePart* part) {
+    std::vector<BasePart*> parts = { part };
+    std::unordered_set<BasePart*> visited = { part };
+
+    for (size_t i = 0; i < parts.size(); i++) {
+        auto it = adjacency.find(parts[i]);
+        if (it == adjacency.end()) continue;
+        for (PhysJointRecord* joint : it->second) {
+            const Edge& edge = edges[joint];
+            if (!edge.rigid) continue;
+            BasePart* other = edge.part0 == parts[i] ? edge.part1 : edge.part0;
+            if (visited.insert(other).second)
+                parts.push_back(other);
+        }
+    }
+
+    return parts;
+}
+
+std::vector<BasePart*> JointGraph::connectedParts(BasePart* part, bool recursive) {
+    std::vector<BasePart*> parts;
+    std::unordered_set<BasePart*> visited = { part };
+
+    std::vector<BasePart*> stack = { part };
+    while (!stack.empty()) {
+        BasePart* current = stack.back();
+        stack.pop_back();
+
+        auto it = adjacency.find(current);
+        if (it == adjacency.end()) continue;
+        for (PhysJointRecord* joint : it->second) {
+            const Edge& edge = edges[joint];
+            BasePart* other = edge.part0 == current ? edge.part1 : edge.part0;
+            if (!visited.insert(other).second) continue;
+
+            parts.push_back(other);
+            if (recursive) stack.push_back(other);
+        }
+    }
+
+    return parts;
+}
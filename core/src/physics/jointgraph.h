@@ -0,0 +1,58 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+class BasePart;
+struct PhysJointRecord;
+
+// Keeps track of which parts of a physics world are connected by joints. Rigid joints are the ones
+// whose parts are merged into a single assembly. Connectivity is kept in union-finds, one over rigid
+// joints and one over all joints, so that checking whether two parts are connected is near constant
+// time. Removing a joint can split a set, which a union-find can't express, so the set is instead
+// rebuilt on the next query
+class JointGraph {
+    struct Edge {
+        BasePart* part0;
+        BasePart* part1;
+        bool rigid;
+    };
+
+    struct Node {
+        BasePart* parent;
+        int size;
+    };
+
+    struct DisjointSets {
+        // Parts without a joint have no node
+        std::unordered_map<BasePart*, Node> nodes;
+        bool dirty = false;
+
+        BasePart* find(BasePart* part);
+        void unite(BasePart* a, BasePart* b);
+    };
+
+    std::unordered_map<PhysJointRecord*, Edge> edges;
+    // Joints attached to each part
+    std::unordered_map<BasePart*, std::vector<PhysJointRecord*>> adjacency;
+    DisjointSets rigidSets;
+    DisjointSets connectedSets;
+
+    void rebuild(DisjointSets& sets, bool rigidOnly);
+public:
+    void addJoint(PhysJointRecord* joint, BasePart* part0, BasePart* part1, bool rigid);
+    void removeJoint(PhysJointRecord* joint);
+    // Whether a joint merges its parts depends on the parts themselves, so it can change over time
+    void setRigid(PhysJointRecord* joint, bool rigid);
+
+    // Whether there is a joint directly between both parts
+    bool areJoined(BasePart* a, BasePart* b);
+    // Whether both parts are in the same rigid assembly
+    bool areRigidlyConnected(BasePart* a, BasePart* b);
+    // Whether both parts are connected through any chain of joints
+    bool areConnected(BasePart* a, BasePart* b);
+    // The part, followed by every part rigidly connected to it
+    std::vector<BasePart*> rigidComponent(BasePart* part);
+    // Parts joined to the part, or if recursive, every part reachable through joints. The part itself is excluded
+    std::vector<BasePart*> connectedParts(BasePart* part, bool recursive);
+};
@@ -0,0 +1,111 @@
+#include "shapecache.h"
+#include "objects/part/basepart.h"
+#include "objects/part/part.h"
+#include "objects/part/wedgepart.h"
+#include "physics/convert.h"
+
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/Collision/Shape/CylinderShape.h>
+#include <Jolt/Physics/Collision/Shape/ScaledShape.h>
+#include <Jolt/Physics/Collision/Shape/ConvexHullShape.h>
+#include <Jolt/Physics/Collision/Shape/RotatedTranslatedShape.h>
+#include <cmath>
+#include <functional>
+
+// Sizes are snapped to a thousandth of a stud
+#define SHAPE_SIZE_QUANTUM 1000.f
+
+static int32_t quantize(float value) {
+    return (int32_t)std::lround(value * SHAPE_SIZE_QUANTUM);
+}
+
+static float dequantize(int32_t value) {
+    return (float)value / SHAPE_SIZE_QUANTUM;
+}
+
+size_t PhysShapeKeyHash::operator()(const PhysShapeKey& key) const {
+    size_t hash = std::hash<uint8_t>{}((uint8_t)key.kind);
+    hash = hash * 31 + std::hash<int32_t>{}(key.sizeX);
+    hash = hash * 31 + std::hash<int32_t>{}(key.sizeY);
+    hash = hash * 31 + std::hash<int32_t>{}(key.sizeZ);
+    return hash;
+}
+
+PhysShapeKey PhysShapeCache::keyFor(std::shared_ptr<BasePart> basePart) {
+    Vector3 size = basePart->size;
+
+    if (std::shared_ptr<Part> part = std::dynamic_pointer_cast<Part>(basePart)) {
+        switch (part->shape) {
+        case PartType::Ball: {
+            // Only the smallest dimension affects a ball, so normalize the others away
+            int32_t diameter = quantize(glm::min(size.X(), size.Y(), size.Z()));
+            return { PhysShapeKind::Ball, diameter, diameter, diameter };
+        }
+        case PartType::Cylinder: {
+            int32_t diameter = quantize(glm::min(size.Y(), size.Z()));
+            return { PhysShapeKind::Cylinder, quantize(size.X()), diameter, diameter };
+        }
+        default:
+            break;
+        }
+    } else if (std::dynamic_pointer_cast<WedgePart>(basePart)) {
+        return { PhysShapeKind::Wedge, quantize(size.X()), quantize(size.Y()), quantize(size.Z()) };
+    }
+
+    return { PhysShapeKind::Block, quantize(size.X()), quantize(size.Y()), quantize(size.Z()) };
+}
+
+static JPH::Ref<JPH::Shape> unitWedgeShape() {
+    static JPH::Ref<JPH::Shape> wedgeShape;
+    if (wedgeShape != nullptr) return wedgeShape;
+
+    JPH::Array<JPH::Vec3> wedgeVerts;
+    wedgeVerts.push_back({-1, -1, -1});
+    wedgeVerts.push_back({ 1, -1, -1});
+    wedgeVerts.push_back({-1, -1,  1});
+    wedgeVerts.push_back({ 1, -1,  1});
+    wedgeVerts.push_back({ 1,  1,  1});
+    wedgeVerts.push_back({-1,  1,  1});
+    // // Invisible bevel to avoid phasing
+    // wedgeVerts.push_back({1, 1, 0.9});
+    // wedgeVerts.push_back({0, 1, 0.9});
+
+    wedgeShape = JPH::ConvexHullShapeSettings(wedgeVerts).Create().Get();
+    return wedgeShape;
+}
+
+JPH::Ref<JPH::Shape> PhysShapeCache::buildShape(PhysShapeKey key) {
+    JPH::Vec3 halfSize(dequantize(key.sizeX) / 2.f, dequantize(key.sizeY) / 2.f, dequantize(key.sizeZ) / 2.f);
+
+    switch (key.kind) {
+    case PhysShapeKind::Block:
+        return new JPH::BoxShape(halfSize, JPH::cDefaultConvexRadius);
+    case PhysShapeKind::Ball:
+        return new JPH::SphereShape(halfSize.GetX());
+    case PhysShapeKind::Cylinder:
+        return new JPH::RotatedTranslatedShape(JPH::Vec3(), JPH::Quat::sEulerAngles(JPH::Vec3(0, 0, JPH::JPH_PI * 0.5)), new JPH::CylinderShape(halfSize.GetX(), halfSize.GetY()));
+    case PhysShapeKind::Wedge:
+        return new JPH::ScaledShape(unitWedgeShape(), halfSize);
+    }
+
+    return nullptr;
+}
+
+JPH::Ref<JPH::Shape> PhysShapeCache::acquire(PhysShapeKey key) {
+    auto it = shapes.find(key);
+    if (it != shapes.end()) return it->second;
+
+    JPH::Ref<JPH::Shape> shape = buildShape(key);
+    shapes[key] = shape;
+    return shape;
+}
+
+void PhysShapeCache::release(PhysShapeKey key) {
+    auto it = shapes.find(key);
+    if (it == shapes.end()) return;
+
+    // Only the cache itself still references this shape
+    if (it->second->GetRefCount() == 1)
+        shapes.erase(it);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Collision/Shape/Shape.h>
+
+class BasePart;
+
+enum class PhysShapeKind : uint8_t {
+    Block,
+    Ball,
+    Cylinder,
+    Wedge,
+};
+
+// Identifies a collision shape by its kind and its size, quantized so that
+// parts differing only by floating point noise share the same shape
+struct PhysShapeKey {
+    PhysShapeKind kind;
+    int32_t sizeX;
+    int32_t sizeY;
+    int32_t sizeZ;
+
+    bool operator==(const PhysShapeKey&) const = default;
+};
+
+struct PhysShapeKeyHash {
+    size_t operator()(const PhysShapeKey& key) const;
+};
+
+// Shapes are immutable once built, so every body with the same shape key can
+// share one instance. The cache holds a reference to each shape, and every
+// body using it holds another; an entry is evicted once the last body has
+// released it
+class PhysShapeCache {
+    std::unordered_map<PhysShapeKey, JPH::Ref<JPH::Shape>, PhysShapeKeyHash> shapes;
+
+    static JPH::Ref<JPH::Shape> buildShape(PhysShapeKey key);
+public:
+    static PhysShapeKey keyFor(std::shared_ptr<BasePart> part);
+
+    // Returns the shared shape for the key, building it on first use
+    JPH::Ref<JPH::Shape> acquire(PhysShapeKey key);
+    // Must be called after a body stops using the shape (i.e. after it was
+    // destroyed or had its shape replaced)
+    void release(PhysShapeKey key);
+
+    inline size_t size() { return shapes.size(); }
+};
@@ -8,6 +8,7 @@
 #include "objects/part/wedgepart.h"
 #include "objects/service/workspace.h"
 #include "physics/convert.h"
+#include "physics/shapecache.h"
 #include "timeutil.h"
 
 #include <Jolt/Jolt.h>
@@ -21,12 +22,10 @@
 #include <Jolt/Physics/Body/BodyInterface.h>
 #include <Jolt/Physics/Body/MotionType.h>
 #include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/ShapeCast.h>
 #include <Jolt/Physics/Collision/Shape/BoxShape.h>
 #include <Jolt/Physics/Collision/Shape/SphereShape.h>
-#include <Jolt/Physics/Collision/Shape/CylinderShape.h>
-#include <Jolt/Physics/Collision/Shape/ScaledShape.h>
-#include <Jolt/Physics/Collision/Shape/ConvexHullShape.h>
-#include <Jolt/Physics/Collision/Shape/RotatedTranslatedShape.h>
+#include <Jolt/Physics/Collision/Shape/StaticCompoundShape.h>
 #include <Jolt/Physics/EActivation.h>
 #include <Jolt/Physics/PhysicsSettings.h>
 #include <Jolt/RegisterTypes.h>
@@ -38,7 +37,11 @@
 #include <Jolt/Physics/Collision/NarrowPhaseQuery.h>
 #include <Jolt/Physics/Constraints/FixedConstraint.h>
 #include <Jolt/Physics/Constraints/HingeConstraint.h>
+#include <algorithm>
 #include <memory>
+#include <unordered_map>
+
+#define MAX_BODIES 4096
 
 static JPH::TempAllocator* allocator;
 static JPH::JobSystem* jobSystem;
@@ -59,8 +62,6 @@ namespace BPLayers
 	static constexpr JPH::uint NUM_LAYERS(3);
 };
 
-static JPH::Ref<JPH::Shape> wedgeShape;
-
 void physicsInit() {
     JPH::RegisterDefaultAllocator();
     JPH::Factory::sInstance = new JPH::Factory();
@@ -68,20 +69,6 @@ void physicsInit() {
 
     allocator = new JPH::TempAllocatorImpl(10 * 1024 * 1024);
     jobSystem = new JPH::JobSystemThreadPool(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::thread::hardware_concurrency() - 1);
-
-    // Create special shapes
-    JPH::Array<JPH::Vec3> wedgeVerts;
-    wedgeVerts.push_back({-1, -1, -1});
-    wedgeVerts.push_back({ 1, -1, -1});
-    wedgeVerts.push_back({-1, -1,  1});
-    wedgeVerts.push_back({ 1, -1,  1});
-    wedgeVerts.push_back({ 1,  1,  1});
-    wedgeVerts.push_back({-1,  1,  1});
-    // // Invisible bevel to avoid phasing
-    // wedgeVerts.push_back({1, 1, 0.9});
-    // wedgeVerts.push_back({0, 1, 0.9});
-
-    wedgeShape = JPH::ConvexHullShapeSettings(wedgeVerts).Create().Get();	
 }
 
 void physicsDeinit() {
@@ -91,13 +78,21 @@ void physicsDeinit() {
 }
 
 PhysWorld::PhysWorld() {
-    worldImpl.Init(4096, 0, 4096, 4096, broadPhaseLayerInterface, objectBroadPhasefilter, objectLayerPairFilter);
-    worldImpl.SetGravity(JPH::Vec3(0, -196, 0));
-	JPH::PhysicsSettings settings = worldImpl.GetPhysicsSettings();
-	// settings.mPointVelocitySleepThreshold = 0.04f; // Fix parts not sleeping
-    // settings.mNumVelocitySteps *= 20;
-    // settings.mNumPositionSteps *= 20;
-	worldImpl.SetPhysicsSettings(settings);
+    worldImpl.Init(MAX_BODIES, 0, 4096, 4096, broadPhaseLayerInterface, objectBroadPhasefilter, objectLayerPairFilter);
+    worldImpl.SetBodyActivationListener(&activationListener);
+    queryCategories.assign(MAX_BODIES, 0);
+    setSimulationSettings(PhysSimulationSettings());
+}
+
+void PhysWorld::setSimulationSettings(PhysSimulationSettings settings) {
+    simulationSettings = settings;
+
+    worldImpl.SetGravity(JPH::Vec3(0, -settings.gravity, 0));
+    JPH::PhysicsSettings physicsSettings = worldImpl.GetPhysicsSettings();
+    physicsSettings.mNumVelocitySteps = settings.velocityIterations;
+    physicsSettings.mNumPositionSteps = settings.positionIterations;
+    physicsSettings.mPointVelocitySleepThreshold = settings.sleepThreshold;
+    worldImpl.SetPhysicsSettings(physicsSettings);
 }
 
 PhysWorld::~PhysWorld() {
@@ -108,6 +103,7 @@ void PhysWorld::addBody(std::shared_ptr<BasePart> part) {
 }
 
 void PhysWorld::removeBody(std::shared_ptr<BasePart> part) {
+    if (part->rigidBody.bodyImpl == nullptr) return;
     JPH::BodyInterface& interface = worldImpl.GetBodyInterface();
 
     // https://jrouwe.github.io/JoltPhysics/index.html#sleeping-bodies
@@ -115,28 +111,83 @@ void PhysWorld::removeBody(std::shared_ptr<BasePart> part) {
     Vector3 aabbSize = part->GetAABB();
     interface.ActivateBodiesInAABox(JPH::AABox(convert<JPH::Vec3>(part->position() - aabbSize), convert<JPH::Vec3>(part->position() + aabbSize)), {}, {});
 
-    interface.RemoveBody(part->rigidBody.bodyImpl->GetID());
-    interface.DestroyBody(part->rigidBody.bodyImpl->GetID());
-    part->rigidBody.bodyImpl = nullptr;
+    removeBodies({ part });
 }
 
-JPH::Shape* makeShape(std::shared_ptr<BasePart> basePart) {
-    if (std::shared_ptr<Part> part = std::dynamic_pointer_cast<Part>(basePart)) {
-        switch (part->shape) {
-        case PartType::Block:
-            return new JPH::BoxShape(convert<JPH::Vec3>(part->size / 2.f), JPH::cDefaultConvexRadius);
-        case PartType::Ball:
-            return new JPH::SphereShape(glm::min(part->size.X(), part->size.Y(), part->size.Z()) / 2.f);
-        case PartType::Cylinder:
-            return new JPH::RotatedTranslatedShape(JPH::Vec3(), JPH::Quat::sEulerAngles(JPH::Vec3(0, 0, JPH::JPH_PI * 0.5)), new JPH::CylinderShape(part->size.X() / 2.f, glm::min(part->size.Z(), part->size.Y()) / 2.f));
+void PhysWorld::removeBodies(const std::vector<std::shared_ptr<BasePart>>& parts) {
+    JPH::BodyInterface& interface = worldImpl.GetBodyInterface();
+
+    for (std::shared_ptr<BasePart> part : parts) {
+        if (part->rigidBody.bodyImpl == nullptr) continue;
+
+        // Split up the part's assembly, the rest of it is regrouped on the next step
+        if (part->rigidBody.assembly != nullptr)
+            dissolveAssembly(part->rigidBody.assembly, dirtyParts);
+
+        // Joints are normally broken before the part leaves the world, but detach any that are left
+        for (PhysJointRecord* record : part->rigidBody.joints) {
+            removeConstraint(record);
+            jointGraph.removeJoint(record);
+            BasePart* other = record->part0 == part.get() ? record->part1 : record->part0;
+            if (record->part0 == part.get()) record->part0 = nullptr;
+            if (record->part1 == part.get()) record->part1 = nullptr;
+            if (other == nullptr || other == part.get()) continue;
+
+            std::erase(other->rigidBody.joints, record);
+            if (record->kind == PhysJointKind::Fixed) dirtyParts.insert(other);
         }
-    } else if (std::shared_ptr<WedgePart> part = std::dynamic_pointer_cast<WedgePart>(basePart)) {
-        return new JPH::ScaledShape(wedgeShape, convert<JPH::Vec3>(part->size / 2.f));
+        part->rigidBody.joints.clear();
+        dirtyParts.erase(part.get());
+    }
+
+    // Every assembly is dissolved by now, so all the bodies are in the world
+    JPH::BodyIDVector bodyIDs;
+    for (std::shared_ptr<BasePart> part : parts) {
+        if (part->rigidBody.bodyImpl != nullptr)
+            bodyIDs.push_back(part->rigidBody.bodyImpl->GetID());
+    }
+    if (bodyIDs.empty()) return;
+
+    interface.RemoveBodies(bodyIDs.data(), (int)bodyIDs.size());
+    interface.DestroyBodies(bodyIDs.data(), (int)bodyIDs.size());
+
+    // Flush the queue so that no event refers to the parts once they are gone
+    for (PhysActivationEvent event : activationListener.takeEvents())
+        setPartAwake(event.part, event.awake);
+
+    for (std::shared_ptr<BasePart> part : parts) {
+        if (part->rigidBody.bodyImpl == nullptr) continue;
+        queryCategories[part->rigidBody.bodyImpl->GetID().GetIndex()] = 0;
+        part->rigidBody.bodyImpl = nullptr;
+        part->rigidBody.world = nullptr;
+        setPartAwake(part.get(), false);
+
+        // The body no longer holds onto its shape
+        if (part->rigidBody._shapeKey.has_value())
+            shapeCache.release(part->rigidBody._shapeKey.value());
+        part->rigidBody._shapeKey = std::nullopt;
     }
-    return nullptr;
 }
 
-void PhysWorld::syncBodyProperties(std::shared_ptr<BasePart> part) {
+void PhysWorld::syncBodyProperties(std::shared_ptr<BasePart> part, PhysSyncFlags flags) {
+    JPH::BodyInterface& interface = worldImpl.GetBodyInterface();
+
+    if (PhysAssembly* assembly = part->rigidBody.assembly) {
+        // Velocity applies to the assembly as a whole, anything else splits it up until the next step
+        if (flags == PHYS_SYNC_VELOCITY) {
+            interface.SetLinearAndAngularVelocity(part->rigidBody.simulatedBody()->GetID(), convert<JPH::Vec3>(part->velocity), convert<JPH::Vec3>(part->rotVelocity));
+            return;
+        }
+        dissolveAssembly(assembly, dirtyParts);
+    } else if ((flags & PHYS_SYNC_MOTION) && !part->rigidBody.joints.empty()) {
+        // CanCollide decides whether the part may be merged into an assembly at all
+        dirtyParts.insert(part.get());
+    }
+
+    applyBodyProperties(part, flags);
+}
+
+void PhysWorld::applyBodyProperties(std::shared_ptr<BasePart> part, PhysSyncFlags flags) {
     JPH::BodyInterface& interface = worldImpl.GetBodyInterface();
 
     JPH::EMotionType motionType = part->anchored ? JPH::EMotionType::Static : JPH::EMotionType::Dynamic;
@@ -144,10 +195,11 @@ void PhysWorld::syncBodyProperties(std::shared_ptr<BasePart> part) {
     JPH::ObjectLayer objectLayer = !part->canCollide ? Layers::NOCOLLIDE : (part->anchored ? Layers::ANCHORED : Layers::DYNAMIC);
 
     JPH::Body* body = part->rigidBody.bodyImpl;
+    PhysShapeKey shapeKey = PhysShapeCache::keyFor(part);
 
     // Generate a new rigidBody
     if (body == nullptr) {
-        JPH::Shape* shape = makeShape(part);
+        JPH::Ref<JPH::Shape> shape = shapeCache.acquire(shapeKey);
         JPH::BodyCreationSettings settings(shape, convert<JPH::Vec3>(part->position()), convert<JPH::Quat>((glm::quat)part->cframe.RotMatrix()), motionType, objectLayer);
         settings.mAllowDynamicOrKinematic = true;
         settings.mRestitution = 0.5;
@@ -155,55 +207,125 @@ void PhysWorld::syncBodyProperties(std::shared_ptr<BasePart> part) {
         body = interface.CreateBody(settings);
         body->SetUserData((JPH::uint64)part.get());
         part->rigidBody.bodyImpl = body;
+        part->rigidBody.world = this;
+        queryCategories[body->GetID().GetIndex()] = part->rigidBody.queryCategoryBits();
 
         interface.AddBody(body->GetID(), activationMode);
         interface.SetLinearVelocity(body->GetID(), convert<JPH::Vec3>(part->velocity));
         interface.SetAngularVelocity(body->GetID(), convert<JPH::Vec3>(part->rotVelocity));
-    } else {
-        std::shared_ptr<Part> part2 = std::dynamic_pointer_cast<Part>(part);
-        bool shouldUpdateShape = (part2 != nullptr && part->rigidBody._lastShape != part2->shape) || part->rigidBody._lastSize == part->size;
+        part->rigidBody._shapeKey = shapeKey;
+        return;
+    }
 
-        if (shouldUpdateShape) {
-            // const JPH::Shape* oldShape = body->GetShape();
-            JPH::Shape* newShape = makeShape(part);
+    JPH::BodyID bodyID = body->GetID();
+    // The body may have been that of an assembly until now
+    queryCategories[bodyID.GetIndex()] = part->rigidBody.queryCategoryBits();
 
-            interface.SetShape(body->GetID(), newShape, true, activationMode);
-            // Seems like Jolt manages its memory for us, so we don't need the below
-            // delete oldShape;
-        }
+    // Only swap shapes if the type or (quantized) size actually changed
+    std::optional<PhysShapeKey> oldShapeKey = part->rigidBody._shapeKey;
+    if ((flags & PHYS_SYNC_SHAPE) && oldShapeKey != shapeKey) {
+        JPH::Ref<JPH::Shape> newShape = shapeCache.acquire(shapeKey);
+        interface.SetShape(bodyID, newShape, true, activationMode);
 
-        interface.SetObjectLayer(body->GetID(), objectLayer);        
-        interface.SetMotionType(body->GetID(), motionType, activationMode);
-        interface.SetPositionRotationAndVelocity(body->GetID(), convert<JPH::Vec3>(part->position()), convert<JPH::Quat>((glm::quat)part->cframe.RotMatrix()), convert<JPH::Vec3>(part->velocity), convert<JPH::Vec3>(part->rotVelocity));
+        if (oldShapeKey.has_value())
+            shapeCache.release(oldShapeKey.value());
+        part->rigidBody._shapeKey = shapeKey;
     }
 
-    part->rigidBody._lastSize = part->size;
-    if (std::shared_ptr<Part> part2 = std::dynamic_pointer_cast<Part>(part)) part->rigidBody._lastShape = part2->shape;
-}
+    if (flags & PHYS_SYNC_MOTION) {
+        // Changing layers and motion types re-inserts the body into the broadphase, so avoid it when possible
+        if (interface.GetObjectLayer(bodyID) != objectLayer)
+            interface.SetObjectLayer(bodyID, objectLayer);
+        if (interface.GetMotionType(bodyID) != motionType)
+            interface.SetMotionType(bodyID, motionType, activationMode);
+    }
 
+    // A teleport only moves the body, it keeps whatever velocity the body already had
+    if (flags & PHYS_SYNC_TRANSFORM)
+        interface.SetPositionAndRotation(bodyID, convert<JPH::Vec3>(part->position()), convert<JPH::Quat>((glm::quat)part->cframe.RotMatrix()), activationMode);
+
+    // Setting a non-zero velocity wakes the body up on its own
+    if (flags & PHYS_SYNC_VELOCITY)
+        interface.SetLinearAndAngularVelocity(bodyID, convert<JPH::Vec3>(part->velocity), convert<JPH::Vec3>(part->rotVelocity));
+}
 tu_time_t physTime;
-void PhysWorld::step(float deltaTime) {
+int physCollisionSteps;
+void PhysWorld::step(float deltaTime, float fallenPartsDestroyHeight) {
     tu_time_t startTime = tu_clock_micros();
-    // Depending on the load, it may be necessary to call this with a differing collision step count
-    // 5 seems to be a good number supporting the high gravity
-    worldImpl.Update(deltaTime, 5, allocator, jobSystem);
+
+    rebuildAssemblies();
+
+    // Update driven joints ahead of the simulation, so that all the bodies they wake up can be
+    // activated in one go. A joint may untrack itself or others mid-loop, see untrackDrivenJoint
+    for (drivenJointCursor = 0; drivenJointCursor < drivenJoints.size();)
+        drivenJoints[drivenJointCursor++]->OnPhysicsStep(deltaTime);
+    drivenJointCursor = 0;
+
+    if (!pendingActivations.empty()) {
+        worldImpl.GetBodyInterface().ActivateBodies(pendingActivations.data(), (int)pendingActivations.size());
+        pendingActivations.clear();
+    }
+
+    worldImpl.Update(deltaTime, simulationSettings.collisionSteps, allocator, jobSystem);
 
     JPH::BodyInterface& interface = worldImpl.GetBodyInterface();
-    JPH::BodyIDVector bodyIDs;
-    worldImpl.GetBodies(bodyIDs);
-    for (JPH::BodyID bodyID : bodyIDs) {
-        std::shared_ptr<BasePart> part = ((Instance*)interface.GetUserData(bodyID))->shared<BasePart>();
-        part->cframe = CFrame(convert<Vector3>(interface.GetPosition(bodyID)), convert<glm::quat>(interface.GetRotation(bodyID)));
-        part->velocity = convert<Vector3>(interface.GetLinearVelocity(bodyID));
-        part->rotVelocity = convert<Vector3>(interface.GetAngularVelocity(bodyID));
+
+    // Bodies that fell asleep during the step still need their final transform written back, so
+    // activations are applied before the writeback and the rest of the events after it
+    std::vector<PhysActivationEvent> activationEvents = activationListener.takeEvents();
+    for (PhysActivationEvent event : activationEvents) {
+        if (event.awake) setPartAwake(event.part, true);
     }
 
-    // Update joints
-    for (std::shared_ptr<JointInstance> joint : drivenJoints) {
-        joint->OnPhysicsStep(deltaTime);
+    movedParts.clear();
+    for (BasePart* part : activeParts) {
+        JPH::BodyID bodyID = part->rigidBody.bodyImpl->GetID();
+        // Bodies of parts merged into an assembly are out of the world, and are written back by the root instead
+        if (!interface.IsAdded(bodyID)) continue;
+
+        CFrame bodyFrame = CFrame(convert<Vector3>(interface.GetPosition(bodyID)), convert<glm::quat>(interface.GetRotation(bodyID)));
+        Vector3 angularVelocity = convert<Vector3>(interface.GetAngularVelocity(bodyID));
+
+        PhysAssembly* assembly = part->rigidBody.assembly;
+        if (assembly == nullptr) {
+            part->cframe = bodyFrame;
+            movedParts.push_back(part);
+            part->velocity = convert<Vector3>(interface.GetLinearVelocity(bodyID));
+            part->rotVelocity = angularVelocity;
+            if (part->position().Y() < fallenPartsDestroyHeight)
+                fallenParts.push_back(part->shared<BasePart>());
+            continue;
+        }
+
+        for (size_t i = 0; i < assembly->parts.size(); i++) {
+            BasePart* member = assembly->parts[i];
+            member->cframe = bodyFrame * assembly->offsets[i];
+            movedParts.push_back(member);
+            member->velocity = convert<Vector3>(interface.GetPointVelocity(bodyID, convert<JPH::Vec3>(member->position())));
+            member->rotVelocity = angularVelocity;
+            if (member->position().Y() < fallenPartsDestroyHeight)
+                fallenParts.push_back(member->shared<BasePart>());
+        }
     }
 
+    for (PhysActivationEvent event : activationEvents)
+        setPartAwake(event.part, event.awake);
+
     physTime = tu_clock_micros() - startTime;
+    physCollisionSteps = simulationSettings.collisionSteps;
+}
+
+// Fixed joints between colliding parts are simulated by merging the parts. Non-colliding parts can't be
+// merged, as the compound shape would make them collide. Queries see an assembly as one body in one
+// category, so parts in different categories aren't merged either
+static bool isMergeableJoint(PhysJointRecord* record) {
+    return record->kind == PhysJointKind::Fixed
+        && record->part0 != nullptr
+        && record->part1 != nullptr
+        && record->part0 != record->part1
+        && record->part0->canCollide
+        && record->part1->canCollide
+        && record->part0->rigidBody.queryCategoryBits() == record->part1->rigidBody.queryCategoryBits();
 }
 
 PhysJoint PhysWorld::createJoint(PhysJointInfo& type, std::shared_ptr<BasePart> part0, std::shared_ptr<BasePart> part1) {
@@ -215,125 +337,635 @@ PhysJoint PhysWorld::createJoint(PhysJointInfo& type, std::shared_ptr<BasePart>
         || part1->workspace()->physicsWorld != shared_from_this()
     ) { Logger::fatalError("Failed to create joint between two parts due to the call being invalid"); panic(); };
 
-    JPH::TwoBodyConstraint* constraint;
+    std::unique_ptr<PhysJointRecord> ownedRecord = std::make_unique<PhysJointRecord>();
+    PhysJointRecord* record = ownedRecord.get();
+    record->part0 = part0.get();
+    record->part1 = part1.get();
+
+    // Check subclasses of PhysRotatingJointInfo first
     if (PhysFixedJointInfo* info = dynamic_cast<PhysFixedJointInfo*>(&type)) {
+        record->kind = PhysJointKind::Fixed;
+        record->c0 = info->c0;
+        record->c1 = info->c1;
+    } else if (PhysMotorizedJointInfo* info = dynamic_cast<PhysMotorizedJointInfo*>(&type)) {
+        record->kind = PhysJointKind::Motor;
+        record->c0 = info->c0;
+        record->c1 = info->c1;
+        record->motorVelocity = info->initialVelocity;
+    } else if (PhysStepperJointInfo* info = dynamic_cast<PhysStepperJointInfo*>(&type)) {
+        record->kind = PhysJointKind::Stepper;
+        record->c0 = info->c0;
+        record->c1 = info->c1;
+    } else if (PhysRotatingJointInfo* info = dynamic_cast<PhysRotatingJointInfo*>(&type)) {
+        record->kind = PhysJointKind::Hinge;
+        record->c0 = info->c0;
+        record->c1 = info->c1;
+    } else {
+        panic();
+    }
+
+    record->index = joints.size();
+    joints.push_back(std::move(ownedRecord));
+    part0->rigidBody.joints.push_back(record);
+    if (part1 != part0) part1->rigidBody.joints.push_back(record);
+    jointGraph.addJoint(record, part0.get(), part1.get(), isMergeableJoint(record));
+
+    // Fixed joints may merge both parts into one assembly, which is decided at the start of the next step
+    if (record->kind == PhysJointKind::Fixed) {
+        dirtyParts.insert(part0.get());
+        dirtyParts.insert(part1.get());
+    } else {
+        buildConstraint(record);
+    }
+
+    return { record, this };
+}
+
+void PhysWorld::rebuildAssemblies() {
+    if (dirtyParts.empty()) return;
+
+    std::unordered_set<BasePart*> affected;
+    std::vector<BasePart*> dirty(dirtyParts.begin(), dirtyParts.end());
+    dirtyParts.clear();
+
+    for (BasePart* part : dirty) {
+        if (part->rigidBody.assembly != nullptr)
+            dissolveAssembly(part->rigidBody.assembly, affected);
+        affected.insert(part);
+
+        // The part may have changed in a way that decides whether its joints can merge it
+        for (PhysJointRecord* record : part->rigidBody.joints)
+            jointGraph.setRigid(record, isMergeableJoint(record));
+    }
+
+    // Regroup every affected part with whatever it is still rigidly connected to
+    std::unordered_set<BasePart*> visited;
+    for (BasePart* start : std::vector<BasePart*>(affected.begin(), affected.end())) {
+        if (visited.contains(start)) continue;
+
+        std::vector<BasePart*> component = jointGraph.rigidComponent(start);
+        for (BasePart* part : component) {
+            visited.insert(part);
+            if (part->rigidBody.assembly != nullptr)
+                dissolveAssembly(part->rigidBody.assembly, affected);
+            affected.insert(part);
+        }
+
+        if (component.size() > 1)
+            formAssembly(component);
+    }
+
+    // The bodies on either end of these joints may have changed
+    std::unordered_set<PhysJointRecord*> rebuilt;
+    for (BasePart* part : affected) {
+        for (PhysJointRecord* record : part->rigidBody.joints) {
+            if (rebuilt.insert(record).second)
+                buildConstraint(record);
+        }
+    }
+}
+
+void PhysWorld::formAssembly(const std::vector<BasePart*>& parts) {
+    JPH::BodyInterface& interface = worldImpl.GetBodyInterface();
+    BasePart* root = parts[0];
+    CFrame rootInverse = root->cframe.Inverse();
+
+    std::unique_ptr<PhysAssembly> assembly = std::make_unique<PhysAssembly>();
+    assembly->root = root;
+
+    // Sub shapes are reordered by the compound shape, so each remembers the index of its part as user data
+    JPH::StaticCompoundShapeSettings settings;
+    bool anchored = false;
+    for (size_t i = 0; i < parts.size(); i++) {
+        CFrame offset = rootInverse * parts[i]->cframe;
+        settings.AddShape(convert<JPH::Vec3>(offset.Position()), convert<JPH::Quat>((glm::quat)offset.RotMatrix()), shapeCache.acquire(parts[i]->rigidBody._shapeKey.value()), (JPH::uint32)i);
+        assembly->parts.push_back(parts[i]);
+        assembly->offsets.push_back(offset);
+        anchored |= parts[i]->anchored;
+    }
+
+    JPH::ShapeSettings::ShapeResult shapeResult = settings.Create();
+    if (shapeResult.HasError()) {
+        Logger::errorf("Failed to build the shape of an assembly of %d parts: %s", (int)parts.size(), shapeResult.GetError().c_str());
+        return;
+    }
+
+    for (size_t i = 0; i < parts.size(); i++) {
+        parts[i]->rigidBody.assembly = assembly.get();
+        parts[i]->rigidBody.assemblyIndex = i;
+        if (parts[i] != root)
+            interface.RemoveBody(parts[i]->rigidBody.bodyImpl->GetID());
+    }
+
+    // If any part is anchored, the assembly as a whole is
+    JPH::BodyID rootID = root->rigidBody.bodyImpl->GetID();
+    queryCategories[rootID.GetIndex()] = root->rigidBody.queryCategoryBits();
+    JPH::EMotionType motionType = anchored ? JPH::EMotionType::Static : JPH::EMotionType::Dynamic;
+    JPH::EActivation activationMode = anchored ? JPH::EActivation::DontActivate : JPH::EActivation::Activate;
+    interface.SetShape(rootID, shapeResult.Get(), true, JPH::EActivation::DontActivate);
+    interface.SetObjectLayer(rootID, anchored ? Layers::ANCHORED : Layers::DYNAMIC);
+    interface.SetMotionType(rootID, motionType, activationMode);
+    // Joints move parts into place without teleporting their bodies, see Weld::buildJoint
+    interface.SetPositionAndRotation(rootID, convert<JPH::Vec3>(root->position()), convert<JPH::Quat>((glm::quat)root->cframe.RotMatrix()), activationMode);
+
+    assemblies.push_back(std::move(assembly));
+}
+
+void PhysWorld::dissolveAssembly(PhysAssembly* assembly, std::unordered_set<BasePart*>& affected) {
+    JPH::BodyInterface& interface = worldImpl.GetBodyInterface();
+
+    for (BasePart* part : assembly->parts) {
+        // These were built against the assembly body
+        for (PhysJointRecord* record : part->rigidBody.joints)
+            removeConstraint(record);
+        part->rigidBody.assembly = nullptr;
+        affected.insert(part);
+    }
+
+    BasePart* root = assembly->root;
+    interface.SetShape(root->rigidBody.bodyImpl->GetID(), shapeCache.acquire(root->rigidBody._shapeKey.value()), true, JPH::EActivation::DontActivate);
+
+    // Frames and velocities were written back by the last step, so each part simply resumes from its own
+    for (BasePart* part : assembly->parts) {
+        if (part != root)
+            interface.AddBody(part->rigidBody.bodyImpl->GetID(), JPH::EActivation::DontActivate);
+        applyBodyProperties(part->shared<BasePart>(), PHYS_SYNC_ALL);
+    }
+
+    auto it = std::find_if(assemblies.begin(), assemblies.end(), [&](const std::unique_ptr<PhysAssembly>& other) { return other.get() == assembly; });
+    *it = std::move(assemblies.back());
+    assemblies.pop_back();
+}
+
+bool PhysRigidBody::isAwake() {
+    if (assembly != nullptr) return assembly->root->rigidBody.activeIndex != -1;
+    return activeIndex != -1;
+}
+
+void PhysWorld::setPartAwake(BasePart* part, bool awake) {
+    int& index = part->rigidBody.activeIndex;
+    if (awake == (index != -1)) return;
+
+    if (awake) {
+        index = (int)activeParts.size();
+        activeParts.push_back(part);
+        return;
+    }
+
+    // Swap with the last part to remove in constant time
+    activeParts[index] = activeParts.back();
+    activeParts[index]->rigidBody.activeIndex = index;
+    activeParts.pop_back();
+    index = -1;
+}
+
+void PhysActivationListener::OnBodyActivated(const JPH::BodyID& bodyID, JPH::uint64 bodyUserData) {
+    std::lock_guard lock(eventsLock);
+    events.push_back({ (BasePart*)bodyUserData, true });
+}
+
+void PhysActivationListener::OnBodyDeactivated(const JPH::BodyID& bodyID, JPH::uint64 bodyUserData) {
+    std::lock_guard lock(eventsLock);
+    events.push_back({ (BasePart*)bodyUserData, false });
+}
+
+std::vector<PhysActivationEvent> PhysActivationListener::takeEvents() {
+    std::lock_guard lock(eventsLock);
+    std::vector<PhysActivationEvent> taken;
+    taken.swap(events);
+    return taken;
+}
+
+void PhysRigidBody::setCollisionsEnabled(bool enabled) {
+    if (collisionsEnabled == enabled) return;
+    collisionsEnabled = enabled;
+    if (world != nullptr) world->updateQueryCategory((BasePart*)bodyImpl->GetUserData());
+}
+
+void PhysRigidBody::setCategoryBits(unsigned short bits) {
+    if (categoryBits == bits) return;
+    categoryBits = bits;
+    if (world != nullptr) world->updateQueryCategory((BasePart*)bodyImpl->GetUserData());
+}
+
+void PhysWorld::updateQueryCategory(BasePart* part) {
+    // Only parts in the same category are merged, so the part has to be regrouped. Dissolving the
+    // assembly also writes back the category of each of its bodies
+    if (part->rigidBody.assembly != nullptr)
+        dissolveAssembly(part->rigidBody.assembly, dirtyParts);
+    else if (!part->rigidBody.joints.empty())
+        dirtyParts.insert(part);
+
+    queryCategories[part->rigidBody.bodyImpl->GetID().GetIndex()] = part->rigidBody.queryCategoryBits();
+}
+
+JPH::Body* PhysRigidBody::simulatedBody() {
+    return assembly != nullptr ? assembly->root->rigidBody.bodyImpl : bodyImpl;
+}
+
+// Joint frames are relative to the part, constraints expect them relative to the center of mass of the body
+CFrame PhysWorld::frameInBody(BasePart* part, const JPH::Body* body, CFrame frame) {
+    if (part->rigidBody.assembly != nullptr)
+        frame = part->rigidBody.assembly->offsets[part->rigidBody.assemblyIndex] * frame;
+    return frame - convert<Vector3>(body->GetShape()->GetCenterOfMass());
+}
+
+void PhysWorld::buildConstraint(PhysJointRecord* record) {
+    removeConstraint(record);
+    if (record->part0 == nullptr || record->part1 == nullptr) return;
+
+    JPH::Body* body0 = record->part0->rigidBody.simulatedBody();
+    JPH::Body* body1 = record->part1->rigidBody.simulatedBody();
+    // Both parts are in the same assembly, and therefore already held together
+    if (body0 == body1) return;
+
+    CFrame c0 = frameInBody(record->part0, body0, record->c0);
+    CFrame c1 = frameInBody(record->part1, body1, record->c1);
+
+    JPH::TwoBodyConstraint* constraint;
+    if (record->kind == PhysJointKind::Fixed) {
         JPH::FixedConstraintSettings settings;
         settings.mSpace = JPH::EConstraintSpace::LocalToBodyCOM;
-        settings.mPoint1 = convert<JPH::Vec3>(info->c0.Position());
-        settings.mAxisX1 = convert<JPH::Vec3>(info->c0.RightVector());
-        settings.mAxisY1 = convert<JPH::Vec3>(info->c0.UpVector());
-        settings.mPoint2 = convert<JPH::Vec3>(info->c1.Position());
-        settings.mAxisX2 = convert<JPH::Vec3>(info->c1.RightVector());
-        settings.mAxisY2 = convert<JPH::Vec3>(info->c1.UpVector());
-        constraint = settings.Create(*part0->rigidBody.bodyImpl, *part1->rigidBody.bodyImpl);
-    } else if (PhysRotatingJointInfo* info = dynamic_cast<PhysRotatingJointInfo*>(&type)) {
+        settings.mPoint1 = convert<JPH::Vec3>(c0.Position());
+        settings.mAxisX1 = convert<JPH::Vec3>(c0.RightVector());
+        settings.mAxisY1 = convert<JPH::Vec3>(c0.UpVector());
+        settings.mPoint2 = convert<JPH::Vec3>(c1.Position());
+        settings.mAxisX2 = convert<JPH::Vec3>(c1.RightVector());
+        settings.mAxisY2 = convert<JPH::Vec3>(c1.UpVector());
+        constraint = settings.Create(*body0, *body1);
+    } else {
         JPH::HingeConstraintSettings settings;
         settings.mSpace = JPH::EConstraintSpace::LocalToBodyCOM;
-        settings.mPoint1 = convert<JPH::Vec3>(info->c0.Position());
-        settings.mNormalAxis1 = convert<JPH::Vec3>(info->c0.RightVector());
-        settings.mHingeAxis1 = convert<JPH::Vec3>(info->c0.LookVector());
-        settings.mPoint2 = convert<JPH::Vec3>(info->c1.Position());
-        settings.mNormalAxis2 = convert<JPH::Vec3>(info->c1.RightVector());
-        settings.mHingeAxis2 = convert<JPH::Vec3>(info->c1.LookVector());
-        
+        settings.mPoint1 = convert<JPH::Vec3>(c0.Position());
+        settings.mNormalAxis1 = convert<JPH::Vec3>(c0.RightVector());
+        settings.mHingeAxis1 = convert<JPH::Vec3>(c0.LookVector());
+        settings.mPoint2 = convert<JPH::Vec3>(c1.Position());
+        settings.mNormalAxis2 = convert<JPH::Vec3>(c1.RightVector());
+        settings.mHingeAxis2 = convert<JPH::Vec3>(c1.LookVector());
+
         // settings for Motor6D
         settings.mMotorSettings.mSpringSettings.mFrequency = 20;
         settings.mMotorSettings.mSpringSettings.mDamping = 1;
-        constraint = settings.Create(*part0->rigidBody.bodyImpl, *part1->rigidBody.bodyImpl);
-        
-        if (PhysMotorizedJointInfo* info = dynamic_cast<PhysMotorizedJointInfo*>(&type)) {
+        constraint = settings.Create(*body0, *body1);
+
+        // Restore the state of the motor, in case the constraint is being rebuilt
+        if (record->kind == PhysJointKind::Motor) {
             static_cast<JPH::HingeConstraint*>(constraint)->SetMotorState(JPH::EMotorState::Velocity);
-            static_cast<JPH::HingeConstraint*>(constraint)->SetTargetAngularVelocity(-info->initialVelocity);
-        } else if (PhysStepperJointInfo* _ = dynamic_cast<PhysStepperJointInfo*>(&type)) {
+            static_cast<JPH::HingeConstraint*>(constraint)->SetTargetAngularVelocity(-record->motorVelocity);
+        } else if (record->kind == PhysJointKind::Stepper) {
             static_cast<JPH::HingeConstraint*>(constraint)->SetMotorState(JPH::EMotorState::Position);
+            static_cast<JPH::HingeConstraint*>(constraint)->SetTargetAngle(record->targetAngle);
         }
-    } else {
-        panic();
     }
 
     worldImpl.AddConstraint(constraint);
-    return { constraint, this };
+    record->constraint = constraint;
+}
+
+void PhysWorld::removeConstraint(PhysJointRecord* record) {
+    if (record->constraint == nullptr) return;
+    worldImpl.RemoveConstraint(record->constraint);
+    record->constraint = nullptr;
 }
 
 void PhysWorld::trackDrivenJoint(std::shared_ptr<JointInstance> motor) {
+    if (motor->drivenJointIndex != -1) return;
+
+    motor->drivenJointIndex = (int)drivenJoints.size();
     drivenJoints.push_back(motor);
 }
 
 void PhysWorld::untrackDrivenJoint(std::shared_ptr<JointInstance> motor) {
-    for (auto it = drivenJoints.begin(); it != drivenJoints.end();) {
-        if (*it == motor)
-            it = drivenJoints.erase(it);
-        else
-            it++;
+    if (motor->drivenJointIndex == -1) return;
+    size_t index = motor->drivenJointIndex;
+
+    // While stepping, the last joint may not have been stepped yet, so it can't be moved in front of
+    // the cursor. Swap with the last joint that was stepped first, which moves the joint to just
+    // behind the cursor
+    if (index < drivenJointCursor) {
+        drivenJointCursor--;
+        std::swap(drivenJoints[index], drivenJoints[drivenJointCursor]);
+        drivenJoints[index]->drivenJointIndex = (int)index;
+        index = drivenJointCursor;
     }
+
+    // Swap with the last joint to remove in constant time
+    drivenJoints[index] = drivenJoints.back();
+    drivenJoints[index]->drivenJointIndex = index;
+    drivenJoints.pop_back();
+    motor->drivenJointIndex = -1;
 }
 
 // WATCH OUT! This should only be called for HingeConstraints.
 // Can't use dynamic_cast because TwoBodyConstraint is not virtual
 void PhysJoint::setAngularVelocity(float velocity) {
-    JPH::HingeConstraint* constraint = static_cast<JPH::HingeConstraint*>(jointImpl);
+    if (record == nullptr) return;
+    record->motorVelocity = velocity;
+    if (record->constraint == nullptr) return;
+
+    JPH::HingeConstraint* constraint = static_cast<JPH::HingeConstraint*>(record->constraint);
     constraint->SetTargetAngularVelocity(-velocity);
 }
 
 void PhysJoint::setTargetAngle(float angle) {
-    JPH::HingeConstraint* constraint = static_cast<JPH::HingeConstraint*>(jointImpl);
+    if (record == nullptr) return;
+    record->targetAngle = angle;
+    if (record->constraint == nullptr) return;
+
+    JPH::HingeConstraint* constraint = static_cast<JPH::HingeConstraint*>(record->constraint);
+    // Leave the bodies alone (and possibly asleep) if nothing changed
+    if (constraint->GetTargetAngle() == angle) return;
     constraint->SetTargetAngle(angle);
 
-    // Wake up the part as it could be sleeping
-    JPH::BodyInterface& interface = parentWorld->worldImpl.GetBodyInterface();
-    JPH::BodyID bodies[] = {constraint->GetBody1()->GetID(), constraint->GetBody2()->GetID()};
-    interface.ActivateBodies(bodies, 2);
+    // Wake up the part as it could be sleeping. This is deferred so that the world can activate
+    // the bodies of every joint at once
+    parentWorld->pendingActivations.push_back(constraint->GetBody1()->GetID());
+    parentWorld->pendingActivations.push_back(constraint->GetBody2()->GetID());
 }
 
 void PhysWorld::destroyJoint(PhysJoint joint) {
-    worldImpl.RemoveConstraint(joint.jointImpl);
+    PhysJointRecord* record = joint.record;
+    if (record == nullptr) return;
+    removeConstraint(record);
+    jointGraph.removeJoint(record);
+
+    for (BasePart* part : { record->part0, record->part1 }) {
+        if (part == nullptr) continue;
+        std::erase(part->rigidBody.joints, record);
+        // The part's assembly may have to be split up
+        if (record->kind == PhysJointKind::Fixed) dirtyParts.insert(part);
+    }
+
+    // Swap with the last record to remove in constant time
+    size_t index = record->index;
+    joints[index] = std::move(joints.back());
+    joints[index]->index = index;
+    joints.pop_back();
 }
 
-class PhysRayCastBodyFilter : public JPH::BodyFilter {
-    bool ShouldCollideLocked(const JPH::Body &inBody) const override {
-        std::shared_ptr<BasePart> part = ((Instance*)inBody.GetUserData())->shared<BasePart>();
+// The include/exclude lists are resolved to body indices once when the filter is
+// built, so the per-candidate checks never have to touch the part
+class PhysQueryBodyFilter : public JPH::BodyFilter {
+    // Indexed by BodyID::GetIndex(), empty if unused
+    std::vector<bool> included;
+    std::vector<bool> excluded;
+    const std::vector<uint16_t>& queryCategories;
+    uint16_t categoryMaskBits;
+    // An assembly is hit through a single body, which can't be filtered by ID if only some of its
+    // parts are included or excluded. Hits on those parts are checked once resolved, see acceptsPart
+    std::unordered_set<PhysAssembly*> partlyIncluded;
+    std::unordered_set<BasePart*> includedMembers;
+    std::unordered_set<BasePart*> excludedMembers;
+
+    // Marks the body of every part within the instances. The body of an assembly is only marked if
+    // all of its parts are, the parts of assemblies that are only partly within are collected instead
+    static void markBodies(std::vector<bool>& bodies, std::unordered_set<BasePart*>& members, const std::vector<std::shared_ptr<Instance>>& instances) {
+        bodies.assign(MAX_BODIES, false);
+
+        std::unordered_set<BasePart*> parts;
+        auto collect = [&](std::shared_ptr<Instance> instance) {
+            if (instance->IsA<BasePart>())
+                parts.insert(instance->CastTo<BasePart>().expect().get());
+        };
+
+        for (std::shared_ptr<Instance> instance : instances) {
+            collect(instance);
+            for (std::shared_ptr<Instance> descendant : instance->GetDescendants())
+                collect(descendant);
+        }
+
+        std::unordered_map<PhysAssembly*, bool> wholeAssemblies;
+        for (BasePart* part : parts) {
+            PhysAssembly* assembly = part->rigidBody.assembly;
+            if (assembly == nullptr) {
+                if (part->rigidBody.bodyImpl != nullptr)
+                    bodies[part->rigidBody.bodyImpl->GetID().GetIndex()] = true;
+                continue;
+            }
+
+            auto [it, inserted] = wholeAssemblies.try_emplace(assembly, false);
+            if (inserted)
+                it->second = std::all_of(assembly->parts.begin(), assembly->parts.end(), [&](BasePart* member) { return parts.contains(member); });
+
+            if (it->second)
+                bodies[assembly->root->rigidBody.bodyImpl->GetID().GetIndex()] = true;
+            else
+                members.insert(part);
+        }
+    }
 
-        // Ignore specifically "hidden" parts from raycast
-        // TODO: Replace this with a better system... Please.
-        if (!part->rigidBody.isCollisionsEnabled()) return false;
+public:
+    PhysQueryBodyFilter(const PhysQueryParams& params, const std::vector<uint16_t>& queryCategories) : queryCategories(queryCategories), categoryMaskBits(params.categoryMaskBits) {
+        if (!params.include.empty()) {
+            markBodies(included, includedMembers, params.include);
+            // The body has to be let through for the included parts to be hit at all
+            for (BasePart* part : includedMembers) {
+                partlyIncluded.insert(part->rigidBody.assembly);
+                included[part->rigidBody.simulatedBody()->GetID().GetIndex()] = true;
+            }
+        }
+        if (!params.exclude.empty()) markBodies(excluded, excludedMembers, params.exclude);
+    }
 
+    // Called before the body is locked, so only the ID is checked here. The body of an assembly is
+    // in the category of its root, which all of its parts share
+    bool ShouldCollide(const JPH::BodyID& bodyID) const override {
+        JPH::uint32 index = bodyID.GetIndex();
+        if ((queryCategories[index] & categoryMaskBits) == 0) return false;
+        if (!included.empty() && !included[index]) return false;
+        if (!excluded.empty() && excluded[index]) return false;
         return true;
     }
+
+    // Whether any hit has to be checked with acceptsPart
+    bool checksParts() const {
+        return !partlyIncluded.empty() || !excludedMembers.empty();
+    }
+
+    bool acceptsPart(BasePart* part) const {
+        if (partlyIncluded.contains(part->rigidBody.assembly) && !includedMembers.contains(part)) return false;
+        return !excludedMembers.contains(part);
+    }
 };
 
-std::optional<const RaycastResult> PhysWorld::castRay(Vector3 point, Vector3 rotation, float maxLength, std::optional<RaycastFilter> filter, unsigned short categoryMaskBits) {
-    if (filter != std::nullopt) { Logger::fatalError("The filter property of PhysWorld::castRay is not yet implemented"); panic(); };
+// A hit produced by a query job, before it is resolved to its part
+struct PhysRawHit {
+    JPH::BodyID bodyID;
+    JPH::SubShapeID subShapeID;
+    float fraction;
+    Vector3 worldPoint;
+    Vector3 worldNormal;
+};
 
-    const JPH::BodyLockInterface& lockInterface = worldImpl.GetBodyLockInterfaceNoLock();
-    const JPH::BodyInterface& interface = worldImpl.GetBodyInterface();
+// Batches are split into jobs of at least this many queries...
+#define CAST_MIN_JOB_SIZE 64
+// ...but never into more than this many jobs, to stay well within cMaxPhysicsJobs
+#define CAST_MAX_JOBS 256
+
+// Runs fn over [0, count) in chunks on the physics job system, and waits for all of them to finish
+static void parallelFor(size_t count, std::function<void(size_t begin, size_t end)> fn) {
+    size_t jobSize = std::max<size_t>(CAST_MIN_JOB_SIZE, (count + CAST_MAX_JOBS - 1) / CAST_MAX_JOBS);
+    if (count <= jobSize) {
+        fn(0, count);
+        return;
+    }
+
+    JPH::JobSystem::Barrier* barrier = jobSystem->CreateBarrier();
+    for (size_t begin = 0; begin < count; begin += jobSize) {
+        size_t end = std::min(begin + jobSize, count);
+        JPH::JobHandle job = jobSystem->CreateJob("CastBatch", JPH::Color::sGreen, [&fn, begin, end]() { fn(begin, end); });
+        barrier->AddJob(job);
+    }
+    jobSystem->WaitForJobs(barrier);
+    jobSystem->DestroyBarrier(barrier);
+}
+
+static PhysRawHit makeRawHit(const JPH::BodyLockInterface& lockInterface, JPH::BodyID bodyID, JPH::SubShapeID subShapeID, float fraction, JPH::Vec3 worldPoint) {
+    PhysRawHit hit { bodyID, subShapeID, fraction, convert<Vector3>(worldPoint), Vector3() };
+
+    JPH::BodyLockRead lock(lockInterface, bodyID);
+    if (lock.Succeeded())
+        hit.worldNormal = convert<Vector3>(lock.GetBody().GetWorldSpaceSurfaceNormal(subShapeID, worldPoint));
+    return hit;
+}
+
+std::optional<const RaycastResult> PhysWorld::castRay(Vector3 point, Vector3 rotation, float maxLength, const PhysQueryParams& params) {
+    return castRays({ PhysRay { point, rotation, maxLength } }, params)[0];
+}
+
+std::vector<std::optional<RaycastResult>> PhysWorld::castRays(const std::vector<PhysRay>& rays, const PhysQueryParams& params) {
     const JPH::NarrowPhaseQuery& query = worldImpl.GetNarrowPhaseQuery();
+    const JPH::BodyLockInterface& lockInterface = worldImpl.GetBodyLockInterface();
+    PhysQueryBodyFilter bodyFilter(params, queryCategories);
+    // Without a filter, only the nearest hit can ever be the result
+    bool collectAll = params.filter.has_value() || bodyFilter.checksParts();
+
+    std::vector<std::vector<PhysRawHit>> hits(rays.size());
+    parallelFor(rays.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const PhysRay& ray = rays[i];
+            JPH::RRayCast jphRay { convert<JPH::Vec3>(ray.origin), convert<JPH::Vec3>(ray.direction.Unit() * ray.maxLength) };
+
+            if (collectAll) {
+                JPH::AllHitCollisionCollector<JPH::CastRayCollector> collector;
+                query.CastRay(jphRay, JPH::RayCastSettings(), collector, {}, {}, bodyFilter);
+                collector.Sort();
+
+                for (const JPH::RayCastResult& result : collector.mHits)
+                    hits[i].push_back(makeRawHit(lockInterface, result.mBodyID, result.mSubShapeID2, result.mFraction, jphRay.GetPointOnRay(result.mFraction)));
+            } else {
+                JPH::RayCastResult result;
+                if (query.CastRay(jphRay, result, {}, {}, bodyFilter))
+                    hits[i].push_back(makeRawHit(lockInterface, result.mBodyID, result.mSubShapeID2, result.mFraction, jphRay.GetPointOnRay(result.mFraction)));
+            }
+        }
+    });
+
+    return resolveHits(hits, bodyFilter, params.filter);
+}
+
+std::vector<std::optional<RaycastResult>> PhysWorld::castSpheres(const std::vector<PhysRay>& casts, float radius, const PhysQueryParams& params) {
+    // Jolt can't build a sphere without volume
+    if (!(radius > 0.f)) {
+        Logger::errorf("Cannot cast spheres of radius %f, it must be positive", radius);
+        return std::vector<std::optional<RaycastResult>>(casts.size());
+    }
+
+    JPH::Ref<JPH::Shape> sphere = new JPH::SphereShape(radius);
+    return castShapes(sphere, casts, CFrame(), params);
+}
+
+std::vector<std::optional<RaycastResult>> PhysWorld::castBoxes(const std::vector<PhysRay>& casts, Vector3 size, CFrame rotation, const PhysQueryParams& params) {
+    if (!(size.X() > 0.f && size.Y() > 0.f && size.Z() > 0.f)) {
+        Logger::errorf("Cannot cast boxes of size %s, every axis must be positive", size.ToString().c_str());
+        return std::vector<std::optional<RaycastResult>>(casts.size());
+    }
+
+    JPH::Vec3 halfSize = convert<JPH::Vec3>(size / 2.f);
+    // The convex radius may not exceed the box itself
+    float convexRadius = std::min(JPH::cDefaultConvexRadius, halfSize.ReduceMin());
+    JPH::Ref<JPH::Shape> box = new JPH::BoxShape(halfSize, convexRadius);
+    return castShapes(box, casts, rotation, params);
+}
+
+std::vector<std::optional<RaycastResult>> PhysWorld::castShapes(const JPH::Shape* shape, const std::vector<PhysRay>& casts, CFrame rotation, const PhysQueryParams& params) {
+    const JPH::NarrowPhaseQuery& query = worldImpl.GetNarrowPhaseQuery();
+    PhysQueryBodyFilter bodyFilter(params, queryCategories);
+    bool collectAll = params.filter.has_value() || bodyFilter.checksParts();
+    JPH::Quat jphRotation = convert<JPH::Quat>((glm::quat)rotation.RotMatrix());
+
+    std::vector<std::vector<PhysRawHit>> hits(casts.size());
+    parallelFor(casts.size(), [&](size_t begin, size_t end) {
+        JPH::ShapeCastSettings settings;
+
+        for (size_t i = begin; i < end; i++) {
+            const PhysRay& cast = casts[i];
+            JPH::RShapeCast shapeCast(shape, JPH::Vec3::sReplicate(1.f), JPH::RMat44::sRotationTranslation(jphRotation, convert<JPH::Vec3>(cast.origin)), convert<JPH::Vec3>(cast.direction.Unit() * cast.maxLength));
+
+            // The contact point is on the surface of the hit body, and the penetration axis points into it
+            auto addHit = [&](const JPH::ShapeCastResult& result) {
+                PhysRawHit hit { result.mBodyID2, result.mSubShapeID2, result.mFraction, convert<Vector3>(result.mContactPointOn2), convert<Vector3>(-result.mPenetrationAxis.NormalizedOr(JPH::Vec3::sZero())) };
+                hits[i].push_back(hit);
+            };
+
+            if (collectAll) {
+                JPH::AllHitCollisionCollector<JPH::CastShapeCollector> collector;
+                query.CastShape(shapeCast, settings, JPH::RVec3::sZero(), collector, {}, {}, bodyFilter);
+                collector.Sort();
+
+                for (const JPH::ShapeCastResult& result : collector.mHits)
+                    addHit(result);
+            } else {
+                JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> collector;
+                query.CastShape(shapeCast, settings, JPH::RVec3::sZero(), collector, {}, {}, bodyFilter);
+
+                if (collector.HadHit())
+                    addHit(collector.mHit);
+            }
+        }
+    });
+
+    return resolveHits(hits, bodyFilter, params.filter);
+}
+
+std::vector<std::optional<RaycastResult>> PhysWorld::resolveHits(const std::vector<std::vector<PhysRawHit>>& hits, const PhysQueryBodyFilter& bodyFilter, std::optional<RaycastFilter> filter) {
+    const JPH::BodyLockInterface& lockInterface = worldImpl.GetBodyLockInterfaceNoLock();
+    const JPH::BodyInterface& interface = worldImpl.GetBodyInterfaceNoLock();
+
+    std::vector<std::optional<RaycastResult>> results(hits.size());
+    for (size_t i = 0; i < hits.size(); i++) {
+        // Hits are sorted nearest first
+        for (const PhysRawHit& hit : hits[i]) {
+            std::shared_ptr<BasePart> part = ((Instance*)interface.GetUserData(hit.bodyID))->shared<BasePart>();
+
+            // An assembly is hit as a whole, so find out which of its parts it was
+            if (PhysAssembly* assembly = part->rigidBody.assembly) {
+                JPH::RefConst<JPH::Shape> shape = interface.GetShape(hit.bodyID);
+                if (shape->GetType() == JPH::EShapeType::Compound) {
+                    const JPH::CompoundShape* compound = static_cast<const JPH::CompoundShape*>(shape.GetPtr());
+                    JPH::SubShapeID remainder;
+                    JPH::uint32 index = compound->GetCompoundUserData(compound->GetSubShapeIndexFromID(hit.subShapeID, remainder));
+                    part = assembly->parts[index]->shared<BasePart>();
+                }
+            }
+            if (!bodyFilter.acceptsPart(part.get())) continue;
+
+            FilterResult action = filter.has_value() ? filter.value()(part) : TARGET;
+
+            if (action == PASS) continue;
+            if (action == TARGET) {
+                results[i] = RaycastResult {
+                    .worldPoint = hit.worldPoint,
+                    .worldNormal = hit.worldNormal,
+                    .body = lockInterface.TryGetBody(hit.bodyID),
+                    .hitPart = part,
+                };
+            }
+            break;
+        }
+    }
 
-    // First we cast a ray to find a matching part
-    Vector3 end = point + rotation.Unit() * maxLength;
-    JPH::RRayCast ray { convert<JPH::Vec3>(point), convert<JPH::Vec3>(end) };
-    JPH::RayCastResult result;
-    PhysRayCastBodyFilter bodyFilter;
-    bool hitFound = query.CastRay(ray, result, {}, {}, bodyFilter);
-    
-    // No matches found, return empty
-    if (!hitFound) return std::nullopt;
-
-    // Next we cast a ray to find the hit surface and its world position and normal
-    JPH::BodyID hitBodyId = result.mBodyID;
-    std::shared_ptr<BasePart> part = ((Instance*)interface.GetUserData(hitBodyId))->shared<BasePart>();
-    const JPH::Shape* shape = interface.GetShape(hitBodyId);
-
-    // Find the hit position and hence the surface normal of the shape at that specific point
-    Vector3 hitPosition = point + rotation.Unit() * (maxLength * result.mFraction);
-    JPH::Vec3 surfaceNormal = shape->GetSurfaceNormal(result.mSubShapeID2, convert<JPH::Vec3>(part->cframe.Inverse() * hitPosition));
-    Vector3 worldNormal = part->cframe.Rotation() * convert<Vector3>(surfaceNormal);
-
-    return RaycastResult {
-        .worldPoint = hitPosition,
-        .worldNormal = worldNormal,
-        .body = lockInterface.TryGetBody(hitBodyId),
-        .hitPart = part,
-    };
+    return results;
 }
 
 JPH::uint BroadPhaseLayerInterface::GetNumBroadPhaseLayers() const {
@@ -3,20 +3,38 @@
 #include "datatypes/cframe.h"
 #include "datatypes/vector.h"
 #include "enum/part.h"
+#include "physics/jointgraph.h"
+#include "physics/shapecache.h"
 #include "utils.h"
+#include <cstdint>
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_set>
+#include <vector>
 
 #include <Jolt/Jolt.h>
 #include <Jolt/Physics/Body/Body.h>
+#include <Jolt/Physics/Body/BodyActivationListener.h>
 #include <Jolt/Physics/PhysicsSystem.h>
 #include <Jolt/Physics/Constraints/TwoBodyConstraint.h>
 
 class BasePart;
+class Instance;
 class JointInstance;
 class PhysWorld;
 
+// Selects which physical attributes of a part are pushed onto its body by
+// PhysWorld::syncBodyProperties
+typedef int PhysSyncFlags;
+const PhysSyncFlags PHYS_SYNC_TRANSFORM = 1 << 0; // Position and rotation (teleports the body)
+const PhysSyncFlags PHYS_SYNC_VELOCITY = 1 << 1; // Linear and angular velocity
+const PhysSyncFlags PHYS_SYNC_SHAPE = 1 << 2; // Shape type and size
+const PhysSyncFlags PHYS_SYNC_MOTION = 1 << 3; // Motion type and collision layer (Anchored, CanCollide)
+const PhysSyncFlags PHYS_SYNC_ALL = PHYS_SYNC_TRANSFORM | PHYS_SYNC_VELOCITY | PHYS_SYNC_SHAPE | PHYS_SYNC_MOTION;
+
 struct PhysJointInfo { virtual ~PhysJointInfo() = default; protected: PhysJointInfo() = default; };
 
 struct PhysFixedJointInfo : PhysJointInfo {
@@ -46,32 +64,89 @@ struct PhysStepperJointInfo : PhysRotatingJointInfo {
     inline PhysStepperJointInfo(CFrame c0, CFrame c1, float initialAngle, float initialVelocity) : PhysRotatingJointInfo(c0, c1), initialAngle(initialAngle), initialVelocity(initialVelocity) {}
 };
 
+enum class PhysJointKind {
+    Fixed,
+    Hinge,
+    Motor,
+    Stepper,
+};
+
+// World-side state of a joint. Constraints are rebuilt from this whenever the body of either
+// part changes, i.e. when the part is merged into or split off from an assembly
+struct PhysJointRecord {
+    PhysJointKind kind;
+    CFrame c0;
+    CFrame c1;
+    // Reset to null if the part is removed from the world before the joint is destroyed
+    BasePart* part0;
+    BasePart* part1;
+    float motorVelocity = 0;
+    float targetAngle = 0;
+    // Null for fixed joints between parts of the same assembly, as those need no constraint
+    JPH::TwoBodyConstraint* constraint = nullptr;
+    // Position in PhysWorld::joints
+    size_t index;
+};
+
 class PhysWorld;
 struct PhysJoint {
 public:
-    JPH::TwoBodyConstraint* jointImpl;
-    PhysWorld* parentWorld;
+    PhysJointRecord* record = nullptr;
+    PhysWorld* parentWorld = nullptr;
 
     void setAngularVelocity(float velocity);
     void setTargetAngle(float angle);
 };
 
+// Query category every body starts out in
+const unsigned short PHYS_CATEGORY_DEFAULT = 1 << 0;
+
+// Parts connected by fixed joints are simulated as a single body with a compound shape. The body
+// belongs to the root part, the bodies of the other parts are kept around but taken out of the world
+struct PhysAssembly {
+    BasePart* root;
+    // Indexed by the user data of the sub shapes of the compound shape
+    std::vector<BasePart*> parts;
+    // Frame of each part relative to the root
+    std::vector<CFrame> offsets;
+};
+
 struct RaycastResult;
 class PhysRigidBody {
     JPH::Body* bodyImpl = nullptr;
     inline PhysRigidBody(JPH::Body* rigidBody) : bodyImpl(rigidBody) {}
-    Vector3 _lastSize;
-    PartType _lastShape;
+    std::optional<PhysShapeKey> _shapeKey;
+    // Every joint attached to the part
+    std::vector<PhysJointRecord*> joints;
+    PhysAssembly* assembly = nullptr;
+    // Index of the part within its assembly
+    size_t assemblyIndex = 0;
+    // Position in PhysWorld::activeParts, or -1 if the body is asleep
+    int activeIndex = -1;
+
+    // The body the part is currently simulated with, i.e. that of its assembly if it has one
+    JPH::Body* simulatedBody();
+    // Mirrored into PhysWorld::queryCategories, which is what queries read
+    unsigned short categoryBits = PHYS_CATEGORY_DEFAULT;
     bool collisionsEnabled = true;
+    // The world the body is in, if it has one
+    PhysWorld* world = nullptr;
 
     friend PhysWorld;
     friend RaycastResult;
+    friend class PhysQueryBodyFilter;
 public:
     inline PhysRigidBody() {}
 
     inline void setActive(bool active) { if (!bodyImpl) return; }
-    inline void setCollisionsEnabled(bool enabled) { collisionsEnabled = enabled; }
+    void setCollisionsEnabled(bool enabled);
     inline bool isCollisionsEnabled() { return collisionsEnabled; }
+    void setCategoryBits(unsigned short bits);
+    inline unsigned short getCategoryBits() { return categoryBits; }
+    // Bodies with collisions disabled are in no category, and are therefore never hit by queries
+    inline unsigned short queryCategoryBits() { return collisionsEnabled ? categoryBits : 0; }
+    // Parts in an assembly are awake whenever the assembly is
+    bool isAwake();
     void updateCollider(std::shared_ptr<BasePart>);
 };
 
@@ -97,6 +172,27 @@ enum FilterResult {
 class BasePart;
 typedef std::function<FilterResult(std::shared_ptr<BasePart>)> RaycastFilter;
 
+// A single ray, or the sweep of a shape, in a batched cast
+struct PhysRay {
+    Vector3 origin;
+    Vector3 direction; // Does not need to be normalized
+    float maxLength;
+};
+
+// Options shared by every query of a cast
+struct PhysQueryParams {
+    std::optional<RaycastFilter> filter;
+    // Only bodies sharing at least one category bit with the mask are hit
+    unsigned short categoryMaskBits = 0xFFFF;
+    // If not empty, only these parts, or parts descending from these instances, are hit
+    std::vector<std::shared_ptr<Instance>> include;
+    // These parts, and parts descending from these instances, are never hit
+    std::vector<std::shared_ptr<Instance>> exclude;
+};
+
+struct PhysRawHit;
+class PhysQueryBodyFilter;
+
 class BroadPhaseLayerInterface : public JPH::BroadPhaseLayerInterface {
     JPH::uint GetNumBroadPhaseLayers() const override;
     JPH::BroadPhaseLayer GetBroadPhaseLayer(JPH::ObjectLayer inLayer) const override;
@@ -113,35 +209,123 @@ class ObjectLayerPairFilter : public JPH::ObjectLayerPairFilter {
     bool ShouldCollide(JPH::ObjectLayer inLayer1, JPH::ObjectLayer inLayer2) const override;
 };
 
+struct PhysActivationEvent {
+    BasePart* part;
+    bool awake;
+};
+
+// Jolt reports activation changes from within the physics jobs, so they are queued up here and
+// applied to the parts on the main thread
+class PhysActivationListener : public JPH::BodyActivationListener {
+    std::mutex eventsLock;
+    std::vector<PhysActivationEvent> events;
+public:
+    void OnBodyActivated(const JPH::BodyID& bodyID, JPH::uint64 bodyUserData) override;
+    void OnBodyDeactivated(const JPH::BodyID& bodyID, JPH::uint64 bodyUserData) override;
+
+    std::vector<PhysActivationEvent> takeEvents();
+};
+
+// Tunables trading simulation accuracy for throughput
+struct PhysSimulationSettings {
+    // Number of collision detection passes per step
+    int collisionSteps = 5;
+    int velocityIterations = 10;
+    int positionIterations = 2;
+    // Bodies whose points all move slower than this (in studs/s) may fall asleep
+    float sleepThreshold = 0.03f;
+    float gravity = 196.f;
+};
+
 class PhysWorld : public std::enable_shared_from_this<PhysWorld> {
     BroadPhaseLayerInterface broadPhaseLayerInterface;
     ObjectBroadPhaseFilter objectBroadPhasefilter;
     ObjectLayerPairFilter objectLayerPairFilter;
+    PhysShapeCache shapeCache;
+    PhysActivationListener activationListener;
     JPH::PhysicsSystem worldImpl;
-    std::list<std::shared_ptr<BasePart>> simulatedBodies;
-    std::list<std::shared_ptr<JointInstance>> drivenJoints;
+    // Parts whose bodies are awake. Each part knows its own index in here, see PhysRigidBody::activeIndex
+    std::vector<BasePart*> activeParts;
+    // Parts whose transforms were written back by the last step
+    std::vector<BasePart*> movedParts;
+    // Parts found below the destroy height by the last step
+    std::vector<std::shared_ptr<BasePart>> fallenParts;
+    // Each joint knows its own index in here, see JointInstance::drivenJointIndex
+    std::vector<std::shared_ptr<JointInstance>> drivenJoints;
+    // While stepping, the joints before this index have been stepped already
+    size_t drivenJointCursor = 0;
+    // Bodies woken up by joint updates, activated all at once before the next update
+    JPH::BodyIDVector pendingActivations;
+    PhysSimulationSettings simulationSettings;
+    // Each record knows its own index in here
+    std::vector<std::unique_ptr<PhysJointRecord>> joints;
+    std::vector<std::unique_ptr<PhysAssembly>> assemblies;
+    // Decides which parts are merged into assemblies
+    JointGraph jointGraph;
+    // Parts whose fixed joints changed since the last step, and whose assemblies need to be rebuilt
+    std::unordered_set<BasePart*> dirtyParts;
+    // Query category of each body in the world, indexed by BodyID::GetIndex(). Only written on the
+    // main thread, so that queries can read it without locking the body
+    std::vector<uint16_t> queryCategories;
 
     friend PhysJoint;
+    friend PhysRigidBody;
+
+    void rebuildAssemblies();
+    void formAssembly(const std::vector<BasePart*>& parts);
+    // Puts the parts of the assembly back into the world as bodies of their own. The members are
+    // added to affected, so that their joints get rebuilt
+    void dissolveAssembly(PhysAssembly* assembly, std::unordered_set<BasePart*>& affected);
+    static CFrame frameInBody(BasePart* part, const JPH::Body* body, CFrame frame);
+    void buildConstraint(PhysJointRecord* record);
+    void removeConstraint(PhysJointRecord* record);
+    // Pushes the properties onto the part's own body, regardless of assemblies
+    void applyBodyProperties(std::shared_ptr<BasePart>, PhysSyncFlags flags);
+    void setPartAwake(BasePart* part, bool awake);
+    void updateQueryCategory(BasePart* part);
+
+    std::vector<std::optional<RaycastResult>> castShapes(const JPH::Shape* shape, const std::vector<PhysRay>& casts, CFrame rotation, const PhysQueryParams& params);
+    std::vector<std::optional<RaycastResult>> resolveHits(const std::vector<std::vector<PhysRawHit>>& hits, const PhysQueryBodyFilter& bodyFilter, std::optional<RaycastFilter> filter);
 public:
     PhysWorld();
     ~PhysWorld();
 
-    void step(float deltaTime);
+    // Parts that end up below fallenPartsDestroyHeight are collected, see takeFallenParts
+    void step(float deltaTime, float fallenPartsDestroyHeight);
+
+    void setSimulationSettings(PhysSimulationSettings settings);
+    inline const PhysSimulationSettings& getSimulationSettings() { return simulationSettings; }
     
     void addBody(std::shared_ptr<BasePart>);
     void removeBody(std::shared_ptr<BasePart>);
+    // Removes and destroys all the bodies at once, without waking anything up around them
+    void removeBodies(const std::vector<std::shared_ptr<BasePart>>& parts);
 
     PhysJoint createJoint(PhysJointInfo& type, std::shared_ptr<BasePart> part0, std::shared_ptr<BasePart> part1);
     void destroyJoint(PhysJoint joint);
 
+    inline JointGraph& getJointGraph() { return jointGraph; }
+
     void trackDrivenJoint(std::shared_ptr<JointInstance> motor);
     void untrackDrivenJoint(std::shared_ptr<JointInstance> motor);
 
     void setCFrameInternal(std::shared_ptr<BasePart> part, CFrame frame);
 
-    inline const std::list<std::shared_ptr<BasePart>>& getSimulatedBodies() { return simulatedBodies; }
-    void syncBodyProperties(std::shared_ptr<BasePart>);
-    std::optional<const RaycastResult> castRay(Vector3 point, Vector3 rotation, float maxLength, std::optional<RaycastFilter> filter, unsigned short categoryMaskBits);
+    // Only these parts can have moved during the last step, sleeping parts are left out
+    inline const std::vector<BasePart*>& getActiveParts() { return activeParts; }
+    inline const std::vector<BasePart*>& getMovedParts() { return movedParts; }
+    inline std::vector<std::shared_ptr<BasePart>> takeFallenParts() { std::vector<std::shared_ptr<BasePart>> parts; parts.swap(fallenParts); return parts; }
+    void syncBodyProperties(std::shared_ptr<BasePart>, PhysSyncFlags flags = PHYS_SYNC_ALL);
+    std::optional<const RaycastResult> castRay(Vector3 point, Vector3 rotation, float maxLength, const PhysQueryParams& params);
+
+    // Batched casts. The queries themselves are spread over the physics job system,
+    // after which the filter is applied on the calling thread, nearest hit first.
+    // Results are in the same order as the input
+    std::vector<std::optional<RaycastResult>> castRays(const std::vector<PhysRay>& rays, const PhysQueryParams& params);
+    // Casts with a shape without volume are rejected, and miss everything
+    std::vector<std::optional<RaycastResult>> castSpheres(const std::vector<PhysRay>& casts, float radius, const PhysQueryParams& params);
+    // Only the rotation component of the CFrame is used
+    std::vector<std::optional<RaycastResult>> castBoxes(const std::vector<PhysRay>& casts, Vector3 size, CFrame rotation, const PhysQueryParams& params);
 };
 
 void physicsInit();
@@ -1,38 +1,45 @@
 #include "rendering/shader.h"
+#include "rendering/streambuffer.h"
 #include "rendering/texture.h"
 #include "timeutil.h"
+#include <algorithm>
 #include <glad/gl.h>
 #include <glm/ext/vector_float4.hpp>
 #include <string>
+#include <vector>
 
 extern int viewportWidth, viewportHeight;
 extern Texture* debugFontTexture;
 extern Shader* debugFontShader;
 extern Shader* identityShader;
+extern StreamBuffer* streamBuffer;
 
 void drawRect(int x, int y, int width, int height, glm::vec4 color);
+void flushRects();
 
-void drawChar(char c, int x, int y, float scale=1.f) {
-    debugFontShader->use();
-    debugFontTexture->activate(1);
-    debugFontShader->set("fontTex", 1);
-
-    debugFontShader->set("charIndex", (int)c);
-
-    // https://stackoverflow.com/a/10631263
-    int tex = debugFontShader->getAttribute("aTexCoord");
+// Characters queued by drawChar, as <vec2 pos, vec2 tex>
+static std::vector<float> debugTextVertices;
+static unsigned int debugTextVAO = 0;
 
+void drawChar(char c, int x, int y, float scale=1.f) {
     y = viewportHeight - y - 16*scale;
     float x0 = float(x)/viewportWidth, y0 = float(y)/viewportHeight, x1 = ((float)x + 8*scale)/viewportWidth, y1 = ((float)y + 16*scale)/viewportHeight;
     x0 *= 2, y0 *= 2, x1 *= 2, y1 *= 2;
     x0 -= 1, y0 -= 1, x1 -= 1, y1 -= 1;
 
-    glBegin(GL_QUADS);
-        glVertex3f(x0, y0, 0);      glVertexAttrib2f(tex, 1, 1); 
-        glVertex3f(x1, y0, 0);      glVertexAttrib2f(tex, 1, 0); 
-        glVertex3f(x1, y1, 0);      glVertexAttrib2f(tex, 0, 0); 
-        glVertex3f(x0, y1, 0);      glVertexAttrib2f(tex, 0, 1); 
-    glEnd();
+    // Cell of the character in debugfnt.bmp
+    float u0 = float((c-32) % 16) / 16, v0 = float((c-32) / 16) / 8;
+    float u1 = u0 + 1.f/32, v1 = v0 + 1.f/16;
+
+    debugTextVertices.insert(debugTextVertices.end(), {
+        x0, y0, u0, v1,
+        x1, y0, u1, v1,
+        x1, y1, u1, v0,
+
+        x0, y0, u0, v1,
+        x1, y1, u1, v0,
+        x0, y1, u0, v0,
+    });
 }
 
 void drawString(std::string str, int x, int y, float scale=1.f) {
@@ -42,10 +49,34 @@ void drawString(std::string str, int x, int y, float scale=1.f) {
     }
 }
 
+// Draws all the queued characters at once
+static void flushChars() {
+    if (debugTextVAO == 0) {
+        glGenVertexArrays(1, &debugTextVAO);
+        glBindVertexArray(debugTextVAO);
+        glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+    }
+
+    debugFontShader->use();
+    debugFontTexture->activate(1);
+    debugFontShader->set("fontTex", 1);
+
+    glBindVertexArray(debugTextVAO);
+    size_t offset = streamBuffer->push(debugTextVertices.data(), debugTextVertices.size() * sizeof(float));
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)offset);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(offset + 2 * sizeof(float)));
+    glDrawArrays(GL_TRIANGLES, 0, debugTextVertices.size() / 4);
+
+    debugTextVertices.clear();
+}
+
 static tu_time_t lastTime;
 extern tu_time_t renderTime;
 extern tu_time_t physTime;
 extern tu_time_t schedTime;
+extern int physCollisionSteps;
+extern int partsDrawn, partsCulled;
 
 // Draws debug info window
 // Including info about framerates, etc.
@@ -55,7 +86,7 @@ void renderDebugInfo() {
 
     glDisable(GL_DEPTH_TEST);
 
-    drawRect(0, 0, 200, 16*8, glm::vec4(0.2f,0.2f,0.2f,0.8f));
+    drawRect(0, 0, 200, 16*11, glm::vec4(0.2f,0.2f,0.2f,0.8f));
     drawString("FPS: " + std::to_string((int)frames), 0, 16*0);
     drawString(" 1/: " + std::to_string((float)timePassed/1'000'000), 0, 16*1);
 
@@ -66,10 +97,17 @@ void renderDebugInfo() {
     frames = 1/(((float)physTime)/1'000'000);
     drawString("PPS: " + std::to_string((int)frames), 0, 16*4);
     drawString(" 1/: " + std::to_string((float)physTime/1'000'000), 0, 16*5);
+    // Cost of each collision step
+    drawString(" " + std::to_string(physCollisionSteps) + "x: " + std::to_string((float)physTime/1'000'000/std::max(physCollisionSteps, 1)), 0, 16*6);
 
     frames = 1/(((float)schedTime)/1'000'000);
-    drawString("SPS: " + std::to_string((int)frames), 0, 16*6);
-    drawString(" 1/: " + std::to_string((float)schedTime/1'000'000), 0, 16*7);
+    drawString("SPS: " + std::to_string((int)frames), 0, 16*7);
+    drawString(" 1/: " + std::to_string((float)schedTime/1'000'000), 0, 16*8);
+
+    drawString("Drawn: " + std::to_string(partsDrawn), 0, 16*9);
+    drawString("Culled: " + std::to_string(partsCulled), 0, 16*10);
+    flushRects();
+    flushChars();
 
     lastTime = tu_clock_micros();
 }
\ No newline at end of file
@@ -1,4 +1,13 @@
+#include <algorithm>
+#include <cmath>
+#include <glm/ext/vector_float2.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <glm/geometric.hpp>
+#include <vector>
+
 #include "defaultmeshes.h"
+#include "math_helper.h"
+#include "torus.h"
 
 #ifdef _MSC_VER
 #pragma warning( disable : 4305 )
@@ -3492,6 +3501,83 @@ Mesh* ARROW_MESH;
 Mesh* OUTLINE_MESH;
 Mesh* CYLINDER_CHEAP_MESH;
 Mesh* CYLINDER_MESH;
+Mesh* TORUS_MESH;
+Mesh* SPHERE_LOD_MESHES[MESH_LOD_COUNT];
+Mesh* CYLINDER_LOD_MESHES[MESH_LOD_COUNT];
+
+struct GenVertex {
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+static void pushTriangle(std::vector<float>& vertices, GenVertex a, GenVertex b, GenVertex c) {
+    // Front faces are wound clockwise, see glFrontFace in renderParts
+    glm::vec3 outward = a.normal + b.normal + c.normal;
+    if (glm::dot(glm::cross(b.position - a.position, c.position - a.position), outward) > 0)
+        std::swap(b, c);
+
+    for (const GenVertex& vertex : { a, b, c }) {
+        vertices.insert(vertices.end(), {
+            vertex.position.x, vertex.position.y, vertex.position.z,
+            vertex.normal.x, vertex.normal.y, vertex.normal.z,
+            vertex.uv.x, vertex.uv.y,
+        });
+    }
+}
+
+// Cube with each face split into a grid and pushed out onto the unit sphere, like SPHERE_MESH
+static Mesh* genSphereMesh(int subdivisions) {
+    std::vector<float> vertices;
+    glm::vec3 axes[3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+
+    for (int face = 0; face < 6; face++) {
+        glm::vec3 normal = axes[face % 3] * (face < 3 ? 1.f : -1.f);
+        glm::vec3 u = axes[(face + 1) % 3], v = axes[(face + 2) % 3];
+
+        auto point = [&](int a, int b) {
+            glm::vec3 direction = glm::normalize(normal + u * (2.f * a / subdivisions - 1) + v * (2.f * b / subdivisions - 1));
+            return GenVertex { direction * 0.5f, direction, glm::vec2(float(a) / subdivisions, float(b) / subdivisions) };
+        };
+
+        for (int a = 0; a < subdivisions; a++) {
+            for (int b = 0; b < subdivisions; b++) {
+                pushTriangle(vertices, point(a, b), point(a + 1, b), point(a + 1, b + 1));
+                pushTriangle(vertices, point(a, b), point(a + 1, b + 1), point(a, b + 1));
+            }
+        }
+    }
+
+    return new Mesh(vertices.size() / 8, vertices.data());
+}
+
+// Cylinder along the X axis, like CYLINDER_MESH
+static Mesh* genCylinderMesh(int sides) {
+    std::vector<float> vertices;
+
+    for (int i = 0; i < sides; i++) {
+        float angle0 = 2 * PI * i / sides, angle1 = 2 * PI * (i + 1) / sides;
+        glm::vec3 normal0(0, sin(angle0), -cos(angle0)), normal1(0, sin(angle1), -cos(angle1));
+        float u0 = float(i) / sides, u1 = float(i + 1) / sides;
+
+        GenVertex left0 { glm::vec3(-0.5, 0, 0) + normal0 * 0.5f, normal0, { u0, 0 } };
+        GenVertex right0 { glm::vec3(0.5, 0, 0) + normal0 * 0.5f, normal0, { u0, 1 } };
+        GenVertex left1 { glm::vec3(-0.5, 0, 0) + normal1 * 0.5f, normal1, { u1, 0 } };
+        GenVertex right1 { glm::vec3(0.5, 0, 0) + normal1 * 0.5f, normal1, { u1, 1 } };
+        pushTriangle(vertices, left0, right0, right1);
+        pushTriangle(vertices, left0, right1, left1);
+
+        for (float side : { -1.f, 1.f }) {
+            glm::vec3 capNormal(side, 0, 0);
+            pushTriangle(vertices,
+                GenVertex { capNormal * 0.5f, capNormal, { 0.5, 0.5 } },
+                GenVertex { capNormal * 0.5f + normal0 * 0.5f, capNormal, glm::vec2(0.5) + glm::vec2(normal0.y, normal0.z) * 0.5f },
+                GenVertex { capNormal * 0.5f + normal1 * 0.5f, capNormal, glm::vec2(0.5) + glm::vec2(normal1.y, normal1.z) * 0.5f });
+        }
+    }
+
+    return new Mesh(vertices.size() / 8, vertices.data());
+}
 
 void initMeshes() {
     CUBE_MESH = new Mesh(sizeof(CUBE_VERTICES) / sizeof(float) / 8, CUBE_VERTICES);
@@ -3501,6 +3587,15 @@ void initMeshes() {
     OUTLINE_MESH = new Mesh(sizeof(OUTLINE_VERTICES) / sizeof(float) / 8, OUTLINE_VERTICES);
     CYLINDER_CHEAP_MESH = new Mesh(sizeof(CYLINDER_CHEAP_VERTICES) / sizeof(float) / 8, CYLINDER_CHEAP_VERTICES);
     CYLINDER_MESH = new Mesh(sizeof(CYLINDER_VERTICES) / sizeof(float) / 8, CYLINDER_VERTICES);
+
+    SPHERE_LOD_MESHES[0] = SPHERE_MESH;
+    SPHERE_LOD_MESHES[1] = genSphereMesh(4);
+    SPHERE_LOD_MESHES[2] = genSphereMesh(2);
+    CYLINDER_LOD_MESHES[0] = CYLINDER_MESH;
+    CYLINDER_LOD_MESHES[1] = genCylinderMesh(12);
+    CYLINDER_LOD_MESHES[2] = genCylinderMesh(6);
+
+    TORUS_MESH = genTorusMesh(20, 20);
 }
 
 /* Python generator:
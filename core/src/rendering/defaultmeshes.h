@@ -8,5 +8,13 @@ extern Mesh* ARROW_MESH;
 extern Mesh* OUTLINE_MESH;
 extern Mesh* CYLINDER_MESH;
 extern Mesh* CYLINDER_CHEAP_MESH;
+// Drawn with torus.vs, see genTorusMesh
+extern Mesh* TORUS_MESH;
+
+// Levels of detail of SPHERE_MESH and CYLINDER_MESH, which are level 0. The lower levels are
+// generated by initMeshes
+const int MESH_LOD_COUNT = 3;
+extern Mesh* SPHERE_LOD_MESHES[MESH_LOD_COUNT];
+extern Mesh* CYLINDER_LOD_MESHES[MESH_LOD_COUNT];
 
 void initMeshes();
\ No newline at end of file
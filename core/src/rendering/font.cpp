@@ -3,10 +3,14 @@
 #include "panic.h"
 #include "rendering/assets.h"
 #include "rendering/shader.h"
+#include "rendering/streambuffer.h"
 
 #include <glad/gl.h>
 #include <glm/ext/matrix_clip_space.hpp>
+#include <algorithm>
+#include <cstring>
 #include <memory>
+#include <vector>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -18,8 +22,9 @@ FT_Library freetype;
 Shader* fontShader;
 
 extern int viewportWidth, viewportHeight;
+extern StreamBuffer* streamBuffer;
 
-unsigned int textVAO, textVBO;
+unsigned int textVAO;
 
 void fontInit() {
     if (FT_Error err = FT_Init_FreeType(&freetype)) {
@@ -29,21 +34,12 @@ void fontInit() {
 
     fontShader = new Shader("assets/shaders/font.vs", "assets/shaders/font.fs");
 
-    // Set up buffer
+    // Set up vertex array. The vertices are pushed to the stream buffer when drawing, see flushText
     glGenVertexArrays(1, &textVAO);
     glBindVertexArray(textVAO);
-
-    glGenBuffers(1, &textVBO);    
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-
-    // Dynamic, because we update the vertices often           V~~~~~~~~~~~~~~
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);      
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
 }
 
 void fontFinish() {
@@ -53,32 +49,75 @@ void fontFinish() {
     }
 }
 
-static void loadCharTexture(FT_Face& face, FT_BitmapGlyph& glyph_bitmap, Character& character) {
+// Glyph rendered by Freetype, waiting to be packed into the atlas
+struct GlyphBitmap {
+    std::vector<unsigned char> pixels;
+    int width, rows;
+    Character* character;
+};
+
+static void loadCharBitmap(FT_Face& face, FT_BitmapGlyph& glyph_bitmap, Character& character, std::vector<GlyphBitmap>& bitmaps) {
+    FT_Bitmap& bitmap = glyph_bitmap->bitmap;
+
+    // Copy the rows, as the bitmap is freed along with the glyph
+    GlyphBitmap glyph { {}, (int)bitmap.width, (int)bitmap.rows, &character };
+    glyph.pixels.resize(bitmap.width * bitmap.rows);
+    for (unsigned int row = 0; row < bitmap.rows; row++)
+        memcpy(&glyph.pixels[row * bitmap.width], bitmap.buffer + row * bitmap.pitch, bitmap.width);
+    bitmaps.push_back(std::move(glyph));
+
+    character.size = glm::ivec2(bitmap.width, bitmap.rows);
+    character.bearing = glm::ivec2(glyph_bitmap->left, glyph_bitmap->top);
+    character.advance = (unsigned int)face->glyph->advance.x;
+}
+
+const int ATLAS_WIDTH = 512;
+// Keeps linear filtering from bleeding neighbouring glyphs in
+const int ATLAS_PADDING = 1;
+
+// Packs the glyphs into rows, and uploads them as a single texture
+static unsigned int buildAtlas(std::vector<GlyphBitmap>& bitmaps) {
+    // Lay out the glyphs first to find out how tall the atlas has to be
+    std::vector<glm::ivec2> positions;
+    int x = ATLAS_PADDING, y = ATLAS_PADDING, rowHeight = 0;
+    for (GlyphBitmap& glyph : bitmaps) {
+        if (x + glyph.width + ATLAS_PADDING > ATLAS_WIDTH) {
+            x = ATLAS_PADDING;
+            y += rowHeight + ATLAS_PADDING;
+            rowHeight = 0;
+        }
+
+        positions.push_back(glm::ivec2(x, y));
+        x += glyph.width + ATLAS_PADDING;
+        rowHeight = std::max(rowHeight, glyph.rows);
+    }
+    int height = y + rowHeight + ATLAS_PADDING;
+
+    std::vector<unsigned char> pixels(ATLAS_WIDTH * height, 0);
+    for (size_t i = 0; i < bitmaps.size(); i++) {
+        GlyphBitmap& glyph = bitmaps[i];
+        glm::ivec2 position = positions[i];
+
+        for (int row = 0; row < glyph.rows; row++)
+            memcpy(&pixels[(position.y + row) * ATLAS_WIDTH + position.x], &glyph.pixels[row * glyph.width], glyph.width);
+
+        glyph.character->uvMin = glm::vec2(position) / glm::vec2(ATLAS_WIDTH, height);
+        glyph.character->uvMax = glm::vec2(position + glm::ivec2(glyph.width, glyph.rows)) / glm::vec2(ATLAS_WIDTH, height);
+    }
+
     // Generate texture
     unsigned int texture;
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        GL_RED,
-        glyph_bitmap->bitmap.width,
-        glyph_bitmap->bitmap.rows,
-        0,
-        GL_RED,
-        GL_UNSIGNED_BYTE,
-        glyph_bitmap->bitmap.buffer
-    );
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, ATLAS_WIDTH, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
     // set texture options
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // now store character for later use
-    character.ID = texture;
-    character.size = glm::ivec2(glyph_bitmap->bitmap.width, glyph_bitmap->bitmap.rows);
-    character.bearing = glm::ivec2(glyph_bitmap->left, glyph_bitmap->top);
-    character.advance = (unsigned int)face->glyph->advance.x;
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return texture;
 }
 
 std::shared_ptr<Font> loadFont(std::string fontName) {
@@ -100,6 +139,7 @@ std::shared_ptr<Font> loadFont(std::string fontName) {
     FT_Stroker_Set(stroker, 2 * 64, FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_ROUND, 0);
 
     // Load each glyph
+    std::vector<GlyphBitmap> bitmaps;
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     for (unsigned char c = 0; c < 128; c++) {
         // load character glyph 
@@ -110,16 +150,13 @@ std::shared_ptr<Font> loadFont(std::string fontName) {
 
         FT_Glyph glyph;
         FT_BitmapGlyph glyph_bitmap;
-    
-        Character character;
 
         // Render base
         FT_Get_Glyph(face->glyph, &glyph);
         FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_NORMAL, nullptr, true);
         glyph_bitmap = (FT_BitmapGlyph)glyph;
 
-        loadCharTexture(face, glyph_bitmap, character);
-        font->characters[c] = character;
+        loadCharBitmap(face, glyph_bitmap, font->characters[c], bitmaps);
         FT_Done_Glyph(glyph);
         // TODO: Find out how to clear FT_BitmapGlyph... I cant import FT_Bitmap_Done for some reason
 
@@ -130,10 +167,10 @@ std::shared_ptr<Font> loadFont(std::string fontName) {
         FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_NORMAL, nullptr, true);
         glyph_bitmap = reinterpret_cast<FT_BitmapGlyph>(glyph);
 
-        loadCharTexture(face, glyph_bitmap, character);
-        font->strokeCharacters[c] = character;
+        loadCharBitmap(face, glyph_bitmap, font->strokeCharacters[c], bitmaps);
         FT_Done_Glyph(glyph);
     }
+    font->atlas = buildAtlas(bitmaps);
     
     FT_Stroker_Done(stroker);
     FT_Done_Face(face);
@@ -141,16 +178,55 @@ std::shared_ptr<Font> loadFont(std::string fontName) {
     return font;
 }
 
+// Text queued by drawText, as <vec2 pos, vec2 tex, vec3 color>
+static std::vector<float> textVertices;
+static unsigned int textAtlas = 0;
+
 void drawText(std::shared_ptr<Font> font, std::string text, float x, float y, float scale, glm::vec3 color, bool drawStroke) {
+    // Text from different fonts can't share a draw call
+    if (textAtlas != font->atlas)
+        flushText();
+    textAtlas = font->atlas;
+
+    // iterate through all characters
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = text[i];
+        if (c >= 128) continue;
+        Character& ch = drawStroke ? font->strokeCharacters[c] : font->characters[c];
+
+        float xpos = x + ch.bearing.x * scale;
+        float ypos = viewportHeight - y - font->height - (ch.size.y - ch.bearing.y) * scale;
+
+        float w = ch.size.x * scale;
+        float h = ch.size.y * scale;
+        glm::vec2 uv0 = ch.uvMin, uv1 = ch.uvMax;
+
+        textVertices.insert(textVertices.end(), {
+            xpos,     ypos + h,   uv0.x, uv0.y,   color.r, color.g, color.b,
+            xpos,     ypos,       uv0.x, uv1.y,   color.r, color.g, color.b,
+            xpos + w, ypos,       uv1.x, uv1.y,   color.r, color.g, color.b,
+
+            xpos,     ypos + h,   uv0.x, uv0.y,   color.r, color.g, color.b,
+            xpos + w, ypos,       uv1.x, uv1.y,   color.r, color.g, color.b,
+            xpos + w, ypos + h,   uv1.x, uv0.y,   color.r, color.g, color.b,
+        });
+        // now advance cursors for next glyph (note that advance is number of 1/64 pixels)
+        x += (ch.advance >> 6) * scale; // bitshift by 6 to get value in pixels (2^6 = 64)
+    }
+}
+
+void flushText() {
+    if (textVertices.empty()) return;
+
     // activate corresponding render state
     glDisable(GL_CULL_FACE);
     glDisable(GL_DEPTH_TEST);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // TODO: Figure out why when changed to GL_ONE this causes graphical errors
 
     fontShader->use();
-    fontShader->set("textColor", color);
     fontShader->set("text", 0);
     glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textAtlas);
 
     glm::mat4 projection = glm::ortho(0.0f, (float)viewportWidth, 0.0f, (float)viewportHeight);
     fontShader->set("projection", projection);
@@ -159,40 +235,16 @@ void drawText(std::shared_ptr<Font> font, std::string text, float x, float y, fl
     // I'm surprised I missed it but honestly... not so much. I'm an idiot
     glBindVertexArray(textVAO);
 
-    // iterate through all characters
-    for (size_t i = 0; i < text.size(); i++) {
-        unsigned char c = text[i];
-        Character ch = drawStroke ? font->strokeCharacters[c] : font->characters[c];
-
-        float xpos = x + ch.bearing.x * scale;
-        float ypos = viewportHeight - y - font->height - (ch.size.y - ch.bearing.y) * scale;
+    // The vertices land somewhere else in the buffer every time
+    size_t offset = streamBuffer->push(textVertices.data(), textVertices.size() * sizeof(float));
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)offset);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(offset + 4 * sizeof(float)));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        float w = ch.size.x * scale;
-        float h = ch.size.y * scale;
-        // render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.ID);
-
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f },            
-            { xpos,     ypos,       0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 0.0f }           
-        };
-        // render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.ID);
-        // update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        // now advance cursors for next glyph (note that advance is number of 1/64 pixels)
-        x += (ch.advance >> 6) * scale; // bitshift by 6 to get value in pixels (2^6 = 64)
-    }
+    glDrawArrays(GL_TRIANGLES, 0, textVertices.size() / 7);
     glBindTexture(GL_TEXTURE_2D, 0);
+
+    textVertices.clear();
 }
 
 float calcTextWidth(std::shared_ptr<Font> font, std::string text, float scale, bool stroke) {
@@ -200,7 +252,8 @@ float calcTextWidth(std::shared_ptr<Font> font, std::string text, float scale, b
     // iterate through all characters
     for (size_t i = 0; i < text.size(); i++) {
         unsigned char c = text[i];
-        Character ch = stroke ? font->strokeCharacters[c] : font->characters[c];
+        if (c >= 128) continue;
+        Character& ch = stroke ? font->strokeCharacters[c] : font->characters[c];
 
         x += (ch.advance >> 6) * scale;
     }
@@ -7,7 +7,8 @@
 // https://learnopengl.com/In-Practice/Text-Rendering
 
 struct Character {
-    unsigned int ID;  // ID handle of the glyph texture
+    glm::vec2    uvMin;      // Corners of the glyph in the font's atlas
+    glm::vec2    uvMax;
     glm::ivec2   size;       // Size of glyph
     glm::ivec2   bearing;    // Offset from baseline to left/top of glyph
     unsigned int advance;    // Offset to advance to next glyph
@@ -15,6 +16,7 @@ struct Character {
 
 struct Font {
     unsigned int height;
+    unsigned int atlas; // Texture holding every glyph, plain and stroked
     Character characters[128];
     Character strokeCharacters[128];
 };
@@ -22,5 +24,8 @@ struct Font {
 void fontInit();
 void fontFinish();
 std::shared_ptr<Font> loadFont(std::string fontName);
+// Queues the text to be drawn by the next flushText. Text is drawn in the order it was queued
 void drawText(std::shared_ptr<Font> font, std::string text, float x, float y, float scale=1.f, glm::vec3 color = glm::vec3(1,1,1), bool drawStroke = false);
-float calcTextWidth(std::shared_ptr<Font> font, std::string text, float scale = 1.f, bool stroke = false);
\ No newline at end of file
+// Draws all the queued text in a single call
+void flushText();
+float calcTextWidth(std::shared_ptr<Font> font, std::string text, float scale = 1.f, bool stroke = false);
@@ -1,6 +1,8 @@
 #include "frustum.h"
 #include "datatypes/vector.h"
+#include <cmath>
 #include <glm/ext/matrix_clip_space.hpp>
+#include <glm/geometric.hpp>
 
 // https://learnopengl.com/Guest-Articles/2021/Scene/Frustum-Culling
 
@@ -106,4 +108,85 @@ bool Frustum::checkAABB(Vector3 center, Vector3 extents) {
         && top.checkAABBForward(center, extents)
         && bottom.checkAABBForward(center, extents)
         ;
-}
\ No newline at end of file
+}
+
+void AABBArray::set(size_t index, glm::vec3 center, glm::vec3 extents) {
+    centerX[index] = center.x, centerY[index] = center.y, centerZ[index] = center.z;
+    extentX[index] = extents.x, extentY[index] = extents.y, extentZ[index] = extents.z;
+}
+
+void AABBArray::push_back(glm::vec3 center, glm::vec3 extents) {
+    centerX.push_back(center.x), centerY.push_back(center.y), centerZ.push_back(center.z);
+    extentX.push_back(extents.x), extentY.push_back(extents.y), extentZ.push_back(extents.z);
+}
+
+void AABBArray::pop_back() {
+    centerX.pop_back(), centerY.pop_back(), centerZ.pop_back();
+    extentX.pop_back(), extentY.pop_back(), extentZ.pop_back();
+}
+
+void AABBArray::copy(size_t from, size_t index) {
+    centerX[index] = centerX[from], centerY[index] = centerY[from], centerZ[index] = centerZ[from];
+    extentX[index] = extentX[from], extentY[index] = extentY[from], extentZ[index] = extentZ[from];
+}
+
+// https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+FrustumPlanes::FrustumPlanes(glm::mat4 viewProjection) {
+    // glm is column major, so rows have to be gathered across columns
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+    glm::vec4 planes[6] = {
+        rows[3] + rows[0], rows[3] - rows[0],
+        rows[3] + rows[1], rows[3] - rows[1],
+        rows[3] + rows[2], rows[3] - rows[2],
+    };
+
+    for (int i = 0; i < 6; i++) {
+        float length = glm::length(glm::vec3(planes[i]));
+        normalX[i] = planes[i].x / length;
+        normalY[i] = planes[i].y / length;
+        normalZ[i] = planes[i].z / length;
+        distance[i] = planes[i].w / length;
+    }
+}
+
+bool FrustumPlanes::checkBox(glm::vec3 min, glm::vec3 max) const {
+    glm::vec3 center = (min + max) * 0.5f, extents = (max - min) * 0.5f;
+
+    for (int p = 0; p < 6; p++) {
+        float centerDistance = normalX[p] * center.x + normalY[p] * center.y + normalZ[p] * center.z + distance[p];
+        float radius = std::abs(normalX[p]) * extents.x + std::abs(normalY[p]) * extents.y + std::abs(normalZ[p]) * extents.z;
+        if (centerDistance + radius < 0) return false;
+    }
+    return true;
+}
+
+void FrustumPlanes::cull(const AABBArray& boxes, std::vector<uint32_t>& visible) const {
+    size_t count = boxes.size();
+    const float *cx = boxes.centerX.data(), *cy = boxes.centerY.data(), *cz = boxes.centerZ.data();
+    const float *ex = boxes.extentX.data(), *ey = boxes.extentY.data(), *ez = boxes.extentZ.data();
+
+    float absX[6], absY[6], absZ[6];
+    for (int p = 0; p < 6; p++)
+        absX[p] = std::abs(normalX[p]), absY[p] = std::abs(normalY[p]), absZ[p] = std::abs(normalZ[p]);
+
+    // Test everything without branching first, so that the loop can be vectorized, then gather the results.
+    // Only ever used from the render thread
+    static std::vector<uint8_t> inside;
+    inside.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        bool in = true;
+        for (int p = 0; p < 6; p++) {
+            float centerDistance = normalX[p] * cx[i] + normalY[p] * cy[i] + normalZ[p] * cz[i] + distance[p];
+            float radius = absX[p] * ex[i] + absY[p] * ey[i] + absZ[p] * ez[i];
+            in &= centerDistance + radius >= 0;
+        }
+        inside[i] = in;
+    }
+
+    visible.clear();
+    for (size_t i = 0; i < count; i++)
+        if (inside[i]) visible.push_back(i);
+}
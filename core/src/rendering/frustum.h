@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <vector>
 #include "datatypes/vector.h"
 #include "datatypes/cframe.h"
 
@@ -32,4 +37,32 @@ struct Frustum {
 
 private:
     Frustum();
-};
\ No newline at end of file
+};
+
+// World space boxes with one array per component, so that many of them can be culled at once
+struct AABBArray {
+    std::vector<float> centerX, centerY, centerZ;
+    // Half of the size along each axis
+    std::vector<float> extentX, extentY, extentZ;
+
+    inline size_t size() const { return centerX.size(); }
+    void set(size_t index, glm::vec3 center, glm::vec3 extents);
+    void push_back(glm::vec3 center, glm::vec3 extents);
+    void pop_back();
+    // Overwrites the box at index with the one at from
+    void copy(size_t from, size_t index);
+};
+
+// Planes of the view volume, extracted from the view-projection matrix (Gribb & Hartmann).
+// Unlike Frustum, these are meant for culling whole arrays of boxes every frame
+struct FrustumPlanes {
+    // Left, right, bottom, top, near, far. Normals point inwards
+    float normalX[6], normalY[6], normalZ[6], distance[6];
+
+    FrustumPlanes(glm::mat4 viewProjection);
+
+    bool checkBox(glm::vec3 min, glm::vec3 max) const;
+
+    // Replaces the contents of visible with the indices of the boxes that intersect the frustum, in order
+    void cull(const AABBArray& boxes, std::vector<uint32_t>& visible) const;
+};
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <glad/gl.h>
+#include <glm/ext/vector_float4.hpp>
+
+#include "instancedmesh.h"
+#include "mesh.h"
+
+static_assert(sizeof(PartInstance) == 39 * sizeof(float), "PartInstance must not contain padding");
+
+InstancedMesh::InstancedMesh(Mesh* mesh) : mesh(mesh) {
+    glGenBuffers(1, &VBO);
+    glGenVertexArrays(1, &VAO);
+
+    glBindVertexArray(VAO);
+    mesh->bindAttributes();
+    bindInstanceAttributes(0);
+    glBindVertexArray(0);
+}
+
+InstancedMesh::~InstancedMesh() {
+    glDeleteBuffers(1, &VBO);
+    glDeleteVertexArrays(1, &VAO);
+}
+
+// Instance attributes have to be re-pointed to draw from an offset, as
+// glDrawArraysInstancedBaseInstance is not available in GL 3.3
+void InstancedMesh::bindInstanceAttributes(size_t first) {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    GLsizei stride = sizeof(PartInstance);
+    size_t base = first * sizeof(PartInstance);
+
+    auto floatAttribute = [&](int location, int size, size_t offset) {
+        glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, stride, (void*)(base + offset));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    };
+
+    auto intAttribute = [&](int location, int size, size_t offset) {
+        glVertexAttribIPointer(location, size, GL_INT, stride, (void*)(base + offset));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    };
+
+    // Matrices take up one location per column
+    for (int i = 0; i < 4; i++)
+        floatAttribute(3 + i, 4, offsetof(PartInstance, model) + i * sizeof(glm::vec4));
+    for (int i = 0; i < 3; i++)
+        floatAttribute(7 + i, 3, offsetof(PartInstance, normalMatrix) + i * sizeof(glm::vec3));
+    floatAttribute(10, 3, offsetof(PartInstance, color));
+    floatAttribute(11, 2, offsetof(PartInstance, material));
+    floatAttribute(12, 3, offsetof(PartInstance, size));
+    intAttribute(13, 3, offsetof(PartInstance, surfaces));
+    intAttribute(14, 3, offsetof(PartInstance, surfaces) + 3 * sizeof(int));
+
+    boundFirst = first;
+}
+
+void InstancedMesh::upload(const std::vector<PartInstance>& instances, size_t first, size_t last) {
+    count = instances.size();
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    // Grow the buffer, in which case everything has to be uploaded again
+    if (instances.size() > capacity) {
+        capacity = std::max({ instances.size(), capacity * 2, (size_t)64 });
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(PartInstance), NULL, GL_DYNAMIC_DRAW);
+        first = 0, last = instances.size();
+    }
+
+    last = std::min(last, instances.size());
+    if (first >= last) return;
+
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(PartInstance), (last - first) * sizeof(PartInstance), &instances[first]);
+}
+
+void InstancedMesh::setMesh(Mesh* newMesh) {
+    if (newMesh == mesh) return;
+    mesh = newMesh;
+
+    glBindVertexArray(VAO);
+    mesh->bindAttributes();
+    glBindVertexArray(0);
+}
+
+void InstancedMesh::draw(size_t first, size_t count) {
+    if (count == 0) return;
+
+    glBindVertexArray(VAO);
+    if (first != boundFirst)
+        bindInstanceAttributes(first);
+
+    glDrawArraysInstanced(GL_TRIANGLES, 0, mesh->vertexCount, count);
+}
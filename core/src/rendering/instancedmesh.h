@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/ext/matrix_float3x3.hpp>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float2.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <vector>
+
+class Mesh;
+
+// Per-part data read by the phong shader as instanced vertex attributes (locations 3-14).
+// Kept free of padding, as arrays of it are uploaded as is
+struct PartInstance {
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+    glm::vec3 color;
+    glm::vec2 material; // Transparency, reflectance
+    glm::vec3 size;
+    int surfaces[6]; // Indexed by NormalId
+};
+
+// Draws many copies of a mesh in a single call, with one PartInstance each
+class InstancedMesh {
+    Mesh* mesh;
+    unsigned int VAO, VBO;
+    size_t capacity = 0;
+    size_t count = 0;
+    size_t boundFirst = 0;
+
+    void bindInstanceAttributes(size_t first);
+
+public:
+    InstancedMesh(Mesh* mesh);
+    ~InstancedMesh();
+
+    // Replaces the instances, only uploading those in [first, last) unless the buffer has to grow
+    void upload(const std::vector<PartInstance>& instances, size_t first, size_t last);
+    inline void upload(const std::vector<PartInstance>& instances) { upload(instances, 0, instances.size()); }
+    // Draws the same instances with another mesh from now on, e.g. a different level of detail
+    void setMesh(Mesh* mesh);
+    void draw(size_t first, size_t count);
+    inline void draw() { draw(0, count); }
+    inline size_t size() { return count; }
+};
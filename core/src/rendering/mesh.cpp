@@ -13,6 +13,11 @@ Mesh::Mesh(int vertexCount, float *vertices) : vertexCount(vertexCount) {
 
     // Bind vertex attributes to VAO
     glBindVertexArray(VAO);
+    bindAttributes();
+}
+
+void Mesh::bindAttributes() {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(0 * sizeof(float)));
     glEnableVertexAttribArray(0);
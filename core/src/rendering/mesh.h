@@ -9,4 +9,6 @@ public:
     Mesh(int vertexCount, float* vertices);
     ~Mesh();
     void bind();
+    // Points attributes 0-2 of the currently bound VAO at this mesh's vertices
+    void bindAttributes();
 };
\ No newline at end of file
@@ -9,7 +9,11 @@
 #include <glm/gtc/quaternion.hpp>
 #include <glm/matrix.hpp>
 #include <glm/trigonometric.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -25,9 +29,12 @@
 #include "objects/service/selection.h"
 #include "partassembly.h"
 #include "rendering/font.h"
-#include "rendering/mesh2d.h"
+#include "rendering/frustum.h"
+#include "rendering/instancedmesh.h"
+#include "rendering/renderscene.h"
+#include "rendering/streambuffer.h"
 #include "rendering/texture.h"
-#include "rendering/torus.h"
+#include "rendering/uniformbuffer.h"
 #include "shader.h"
 #include "mesh.h"
 #include "defaultmeshes.h"
@@ -43,6 +50,7 @@
 Shader* shader = NULL;
 Shader* skyboxShader = NULL;
 Shader* handleShader = NULL;
+Shader* torusShader = NULL;
 Shader* identityShader = NULL;
 Shader* ghostShader = NULL;
 Shader* wireframeShader = NULL;
@@ -52,7 +60,10 @@ Shader* generic2dShader = NULL;
 Skybox* skyboxTexture = NULL;
 Texture3D* studsTexture = NULL;
 Texture* debugFontTexture = NULL;
-Mesh2D* rect2DMesh = NULL;
+UniformBuffer* cameraBlock = NULL;
+UniformBuffer* lightBlock = NULL;
+// Vertices generated every frame, such as text and 2d overlays
+StreamBuffer* streamBuffer = NULL;
 
 std::shared_ptr<Font> sansSerif;
 
@@ -60,9 +71,14 @@ bool debugRendererEnabled = false;
 bool wireframeRendering = false;
 
 int viewportWidth, viewportHeight;
+// Parts in the last frame that passed and failed culling, shown in the debug overlay
+int partsDrawn = 0, partsCulled = 0;
 
 void renderDebugInfo();
+static void initPartMeshes();
+static void initRects();
 void drawRect(int x, int y, int width, int height, glm::vec4 color);
+void flushRects();
 inline void drawRect(int x, int y, int width, int height, glm::vec3 color) { return drawRect(x, y, width, height, glm::vec4(color, 1)); };
 
 void renderInit(int width, int height) {
@@ -70,6 +86,7 @@ void renderInit(int width, int height) {
     glViewport(0, 0, width, height);
 
     initMeshes();
+    initPartMeshes();
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
@@ -93,6 +110,7 @@ void renderInit(int width, int height) {
     shader = new Shader("assets/shaders/phong.vs", "assets/shaders/phong.fs");
     skyboxShader = new Shader("assets/shaders/skybox.vs", "assets/shaders/skybox.fs");
     handleShader = new Shader("assets/shaders/handle.vs", "assets/shaders/handle.fs");
+    torusShader = new Shader("assets/shaders/torus.vs", "assets/shaders/handle.fs");
     identityShader = new Shader("assets/shaders/identity.vs", "assets/shaders/identity.fs");
     ghostShader = new Shader("assets/shaders/ghost.vs", "assets/shaders/ghost.fs");
     wireframeShader = new Shader("assets/shaders/wireframe.vs", "assets/shaders/wireframe.fs");
@@ -100,18 +118,11 @@ void renderInit(int width, int height) {
     debugFontShader = new Shader("assets/shaders/debug/debugfont.vs", "assets/shaders/debug/debugfont.fs");
     generic2dShader = new Shader("assets/shaders/generic2d.vs", "assets/shaders/generic2d.fs");
 
-    // Create mesh for 2d rectangle
-    float rectVerts[] = {
-        0.0, 0.0,    0.0, 0.0,
-        1.0, 0.0,    1.0, 0.0,
-        1.0, 1.0,    1.0, 1.0,
+    cameraBlock = new UniformBuffer(CAMERA_BLOCK_BINDING, sizeof(CameraBlock));
+    lightBlock = new UniformBuffer(LIGHT_BLOCK_BINDING, sizeof(LightBlock));
 
-        1.0, 1.0,    1.0, 1.0,
-        0.0, 1.0,    0.0, 1.0,
-        0.0, 0.0,    0.0, 0.0,
-    };
-
-    rect2DMesh = new Mesh2D(6, rectVerts);
+    streamBuffer = new StreamBuffer(4 * 1024 * 1024);
+    initRects();
 
     // Initialize fonts
     fontInit();
@@ -130,44 +141,197 @@ inline glm::mat4 getCameraPerspective() {
     return gWorkspace()->GetCamera()->GetCameraPerspective(viewportWidth, viewportHeight);
 }
 
-static void renderPart(std::shared_ptr<BasePart> part) {
-    glm::mat4 model = part->cframe;
-    Vector3 size = part->GetEffectiveSize();
-    model = glm::scale(model, (glm::vec3)size);
-    shader->set("model", model);
-    shader->set("material", Material {
-        .diffuse = part->color,
-        .specular = glm::vec3(0.5f, 0.5f, 0.5f),
-        .shininess = 16.0f,
-    });
-    glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
-    shader->set("normalMatrix", normalMatrix);
-    shader->set("texScale", size);
-    shader->set("transparency", part->transparency);
-    shader->set("reflectance", part->reflectance);
-
-    shader->set("surfaces[" + std::to_string(NormalId::Right) + "]", (int)part->rightSurface);
-    shader->set("surfaces[" + std::to_string(NormalId::Top) + "]", (int)part->topSurface);
-    shader->set("surfaces[" + std::to_string(NormalId::Back) + "]", (int)part->backSurface);
-    shader->set("surfaces[" + std::to_string(NormalId::Left) + "]", (int)part->leftSurface);
-    shader->set("surfaces[" + std::to_string(NormalId::Bottom) + "]", (int)part->bottomSurface);
-    shader->set("surfaces[" + std::to_string(NormalId::Front) + "]", (int)part->frontSurface);
-
-    PartType shape = part->IsA<Part>() ? part->CastTo<Part>().expect()->shape : PartType::Block;
-    if (part->IsA<WedgePart>()) {
-        WEDGE_MESH->bind();
-        glDrawArrays(GL_TRIANGLES, 0, WEDGE_MESH->vertexCount);
-    } else if (shape == PartType::Ball) { // Part
-        SPHERE_MESH->bind();
-        glDrawArrays(GL_TRIANGLES, 0, SPHERE_MESH->vertexCount);
-    } else if (shape == PartType::Block) {
-        glFrontFace(GL_CW);
-        CUBE_MESH->bind();
-        glDrawArrays(GL_TRIANGLES, 0, CUBE_MESH->vertexCount);
-    } else if (shape == PartType::Cylinder) {
-        glFrontFace(GL_CW);
-        CYLINDER_MESH->bind();
-        glDrawArrays(GL_TRIANGLES, 0, CYLINDER_MESH->vertexCount);
+// Visible opaque parts drawn with one mesh at one level of detail
+struct PartBatch {
+    InstancedMesh* mesh = nullptr;
+    // Indices into the bucket of the parts in the batch, and their instances as uploaded
+    std::vector<uint32_t> indices;
+    std::vector<PartInstance> instances;
+};
+
+// Levels of detail missing for a mesh are left null
+static Mesh* partMeshes[PART_MESH_COUNT][MESH_LOD_COUNT];
+static PartBatch opaqueBatches[PART_MESH_COUNT][MESH_LOD_COUNT];
+static InstancedMesh* transparentPartMeshes[PART_MESH_COUNT][MESH_LOD_COUNT];
+
+// Size of a part relative to its distance below which each lower level of detail is used
+static const float LOD_SIZE_RATIOS[MESH_LOD_COUNT - 1] = { 0.1f, 0.03f };
+
+static void initPartMeshes() {
+    Mesh* meshes[PART_MESH_COUNT][MESH_LOD_COUNT] = {
+        { CUBE_MESH },
+        { WEDGE_MESH },
+        { SPHERE_LOD_MESHES[0], SPHERE_LOD_MESHES[1], SPHERE_LOD_MESHES[2] },
+        { CYLINDER_LOD_MESHES[0], CYLINDER_LOD_MESHES[1], CYLINDER_LOD_MESHES[2] },
+    };
+
+    for (int i = 0; i < PART_MESH_COUNT; i++) {
+        for (int lod = 0; lod < MESH_LOD_COUNT; lod++) {
+            partMeshes[i][lod] = meshes[i][lod];
+            if (meshes[i][lod] == nullptr) continue;
+            opaqueBatches[i][lod].mesh = new InstancedMesh(meshes[i][lod]);
+            transparentPartMeshes[i][lod] = new InstancedMesh(meshes[i][lod]);
+        }
+    }
+}
+
+// Distances are compared squared, to avoid taking square roots
+static int lodFor(PartMeshType mesh, float size, float squaredDistance) {
+    if (mesh != PART_MESH_SPHERE && mesh != PART_MESH_CYLINDER) return 0;
+
+    int lod = 0;
+    while (lod < MESH_LOD_COUNT - 1 && size * size < LOD_SIZE_RATIOS[lod] * LOD_SIZE_RATIOS[lod] * squaredDistance)
+        lod++;
+    return lod;
+}
+
+static inline float largestAxis(glm::vec3 size) {
+    return glm::max(size.x, glm::max(size.y, size.z));
+}
+
+static int partLod(PartMeshType mesh, const PartInstance& instance, glm::vec3 cameraPos) {
+    glm::vec3 offset = cameraPos - glm::vec3(instance.model[3]);
+    return lodFor(mesh, largestAxis(instance.size), glm::dot(offset, offset));
+}
+
+// GPU copy of a chunk of anchored parts, see RenderChunk
+struct ChunkMeshes {
+    // Created for the meshes used in the chunk
+    InstancedMesh* meshes[PART_MESH_COUNT] = {};
+    // Largest part per mesh, which picks the level of detail for the whole chunk
+    float largest[PART_MESH_COUNT] = {};
+
+    ~ChunkMeshes() {
+        for (InstancedMesh* mesh : meshes)
+            delete mesh;
+    }
+};
+
+static std::unordered_map<uint64_t, std::unique_ptr<ChunkMeshes>> chunkMeshes;
+
+static void uploadChunk(RenderChunk& chunk, ChunkMeshes& meshes) {
+    for (int i = 0; i < PART_MESH_COUNT; i++) {
+        RenderBucket& bucket = chunk.buckets[i];
+        bucket.clearDirty();
+        if (meshes.meshes[i] == nullptr && bucket.instances.empty()) continue;
+
+        if (meshes.meshes[i] == nullptr)
+            meshes.meshes[i] = new InstancedMesh(partMeshes[i][0]);
+        meshes.meshes[i]->upload(bucket.instances);
+
+        meshes.largest[i] = 0;
+        for (const PartInstance& instance : bucket.instances)
+            meshes.largest[i] = glm::max(meshes.largest[i], largestAxis(instance.size));
+    }
+
+    chunk.changed = false;
+}
+
+static void renderChunks(RenderScene& scene, const FrustumPlanes& frustum, glm::vec3 cameraPos, bool reupload) {
+    std::unordered_map<uint64_t, RenderChunk>& chunks = scene.getChunks();
+
+    // Drop the copies of chunks that have been emptied
+    if (reupload) chunkMeshes.clear();
+    for (auto it = chunkMeshes.begin(); it != chunkMeshes.end();) {
+        if (chunks.count(it->first) == 0)
+            it = chunkMeshes.erase(it);
+        else
+            it++;
+    }
+
+    for (auto& [key, chunk] : chunks) {
+        if (!frustum.checkBox(chunk.min, chunk.max)) {
+            partsCulled += chunk.size;
+            continue;
+        }
+
+        std::unique_ptr<ChunkMeshes>& meshes = chunkMeshes[key];
+        if (meshes == nullptr) {
+            meshes = std::make_unique<ChunkMeshes>();
+            chunk.changed = true;
+        }
+        if (chunk.changed)
+            uploadChunk(chunk, *meshes);
+
+        glm::vec3 offset = cameraPos - glm::clamp(cameraPos, chunk.min, chunk.max);
+        for (int i = 0; i < PART_MESH_COUNT; i++) {
+            if (meshes->meshes[i] == nullptr) continue;
+            meshes->meshes[i]->setMesh(partMeshes[i][lodFor((PartMeshType)i, meshes->largest[i], glm::dot(offset, offset))]);
+            meshes->meshes[i]->draw();
+        }
+        partsDrawn += chunk.size;
+    }
+}
+
+// Scene whose instances are in the part meshes. Everything has to be uploaded again when
+// the workspace is swapped, e.g. when starting or stopping a simulation
+static std::weak_ptr<RenderScene> uploadedScene;
+
+// As long as the same parts stay in the batch, only the ones that changed are uploaded again
+static void uploadBatch(PartBatch& batch, RenderBucket& bucket, std::vector<uint32_t>& indices, bool reupload) {
+    if (reupload || indices != batch.indices) {
+        batch.indices.swap(indices);
+        batch.instances.resize(batch.indices.size());
+        for (size_t j = 0; j < batch.indices.size(); j++)
+            batch.instances[j] = bucket.instances[batch.indices[j]];
+        batch.mesh->upload(batch.instances);
+    } else if (bucket.dirtyFirst != bucket.dirtyLast) {
+        // Indices are in order, so the dirty range maps onto a range of the uploaded instances
+        size_t first = std::lower_bound(batch.indices.begin(), batch.indices.end(), bucket.dirtyFirst) - batch.indices.begin();
+        size_t last = std::lower_bound(batch.indices.begin(), batch.indices.end(), bucket.dirtyLast) - batch.indices.begin();
+        for (size_t j = first; j < last; j++)
+            batch.instances[j] = bucket.instances[batch.indices[j]];
+        batch.mesh->upload(batch.instances, first, last);
+    }
+}
+
+// Transparent part waiting to be sorted, see sortBackToFront
+struct DepthItem {
+    uint32_t key;
+    PartMeshType mesh;
+    int lod;
+    uint32_t index;
+};
+
+// Consecutive transparent parts sharing a mesh, drawn in one call
+struct TransparentRun {
+    PartMeshType mesh;
+    int lod;
+    size_t count;
+};
+
+// Distances are positive, so their bits already order like integers. Inverting them puts the
+// furthest parts first
+static inline uint32_t depthKey(float squaredDistance) {
+    uint32_t bits;
+    memcpy(&bits, &squaredDistance, sizeof(float));
+    return ~bits;
+}
+
+// Radix sort, one byte of the key per pass. It is stable, so parts at the same distance keep
+// a consistent order from frame to frame instead of flickering
+static void sortBackToFront(std::vector<DepthItem>& items, std::vector<DepthItem>& scratch) {
+    if (items.size() < 2) return;
+    scratch.resize(items.size());
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        size_t offsets[256] = {};
+        for (DepthItem& item : items)
+            offsets[(item.key >> shift) & 0xFF]++;
+
+        // Every key shares this byte, so the pass wouldn't change anything
+        if (offsets[(items[0].key >> shift) & 0xFF] == items.size()) continue;
+
+        size_t total = 0;
+        for (size_t& offset : offsets) {
+            size_t count = offset;
+            offset = total;
+            total += count;
+        }
+
+        for (DepthItem& item : items)
+            scratch[offsets[(item.key >> shift) & 0xFF]++] = item;
+        items.swap(scratch);
     }
 }
 
@@ -175,54 +339,108 @@ void renderParts() {
     glDepthMask(GL_TRUE);
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
+    glFrontFace(GL_CW);
     glEnable(GL_BLEND);
     glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     // Use shader
     shader->use();
 
-    // view/projection transformations
-    glm::mat4 projection = getCameraPerspective();
-    glm::mat4 view = getCameraLookAt();
-    shader->set("projection", projection);
-    shader->set("view", view);
-    shader->set("sunLight", DirLight {
-        .direction = glm::vec3(-0.2f, -1.0f, -0.3f),
-        .ambient = glm::vec3(0.2f, 0.2f, 0.2f),
-        .diffuse = glm::vec3(0.5f, 0.5f, 0.5f),
-        .specular = glm::vec3(1.0f, 1.0f, 1.0f),
-    });
     shader->set("numPointLights", 0);
     studsTexture->activate(0);
     shader->set("studs", 0);
     skyboxTexture->activate(1);
     shader->set("skybox", 1);
 
-    // Pre-calculate the normal matrix for the shader
+    // The diffuse color comes from each part's instance data
+    shader->set("material", Material {
+        .diffuse = glm::vec3(1.0f),
+        .specular = glm::vec3(0.5f, 0.5f, 0.5f),
+        .shininess = 16.0f,
+    });
 
-    // Pass in the camera position
-    shader->set("viewPos", getCameraPos());
-    
+    std::shared_ptr<RenderScene> scene = gWorkspace()->GetRenderScene();
+    scene->update();
+    bool reupload = uploadedScene.lock() != scene;
+    uploadedScene = scene;
 
-    // Sort by nearest
-    std::map<float, std::shared_ptr<BasePart>> sorted;
-    for (auto&& it : gWorkspace()->GetDescendants()) {
-        if (!it->IsA<BasePart>()) continue;
-        std::shared_ptr<BasePart> part = std::dynamic_pointer_cast<BasePart>(it);
+    FrustumPlanes frustum(getCameraPerspective() * getCameraLookAt());
+    glm::vec3 cameraPos = getCameraPos();
+    static std::vector<uint32_t> visible, lodVisible[MESH_LOD_COUNT];
+    partsDrawn = 0, partsCulled = 0;
 
-        if (part->transparency > 0.00001) {
-            float distance = glm::length(glm::vec3(Vector3(getCameraPos()) - part->position()));
-            sorted[distance] = part;
-        } else {
-            renderPart(part);
+    // Opaque parts can be drawn in any order, so draw each mesh all at once
+    for (int i = 0; i < PART_MESH_COUNT; i++) {
+        RenderBucket& bucket = scene->getBucket((PartMeshType)i, false);
+        frustum.cull(bucket.bounds, visible);
+
+        for (std::vector<uint32_t>& indices : lodVisible)
+            indices.clear();
+        for (uint32_t j : visible)
+            lodVisible[partLod((PartMeshType)i, bucket.instances[j], cameraPos)].push_back(j);
+
+        for (int lod = 0; lod < MESH_LOD_COUNT; lod++) {
+            PartBatch& batch = opaqueBatches[i][lod];
+            if (batch.mesh == nullptr) continue;
+
+            uploadBatch(batch, bucket, lodVisible[lod], reupload);
+            batch.mesh->draw();
+        }
+        bucket.clearDirty();
+
+        partsDrawn += visible.size();
+        partsCulled += bucket.instances.size() - visible.size();
+    }
+
+    renderChunks(*scene, frustum, cameraPos, reupload);
+
+    // Reused from frame to frame to avoid allocating
+    static std::vector<DepthItem> sorted, sortScratch;
+    sorted.clear();
+
+    for (int i = 0; i < PART_MESH_COUNT; i++) {
+        RenderBucket& bucket = scene->getBucket((PartMeshType)i, true);
+        bucket.clearDirty();
+        frustum.cull(bucket.bounds, visible);
+
+        partsDrawn += visible.size();
+        partsCulled += bucket.instances.size() - visible.size();
+        for (uint32_t j : visible) {
+            glm::vec3 offset = cameraPos - glm::vec3(bucket.instances[j].model[3]);
+            int lod = partLod((PartMeshType)i, bucket.instances[j], cameraPos);
+            sorted.push_back(DepthItem { depthKey(glm::dot(offset, offset)), (PartMeshType)i, lod, j });
         }
     }
+    sortBackToFront(sorted, sortScratch);
+
+    // Transparent parts have to be drawn back to front, so only consecutive
+    // parts sharing a mesh can be drawn together
+    static std::vector<PartInstance> transparentInstances[PART_MESH_COUNT][MESH_LOD_COUNT];
+    for (auto& lods : transparentInstances)
+        for (std::vector<PartInstance>& instances : lods)
+            instances.clear();
+
+    static std::vector<TransparentRun> runs;
+    runs.clear();
+    for (DepthItem& item : sorted) {
+        transparentInstances[item.mesh][item.lod].push_back(scene->getBucket(item.mesh, true).instances[item.index]);
+
+        if (!runs.empty() && runs.back().mesh == item.mesh && runs.back().lod == item.lod)
+            runs.back().count++;
+        else
+            runs.push_back(TransparentRun { item.mesh, item.lod, 1 });
+    }
+
+    for (int i = 0; i < PART_MESH_COUNT; i++)
+        for (int lod = 0; lod < MESH_LOD_COUNT; lod++)
+            if (transparentPartMeshes[i][lod] != nullptr)
+                transparentPartMeshes[i][lod]->upload(transparentInstances[i][lod]);
 
-    // TODO: Same as todo in src/physics/simulation.cpp
-    // According to LearnOpenGL, std::map automatically sorts its contents.
-    for (std::map<float, std::shared_ptr<BasePart>>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); it++) {
-        std::shared_ptr<BasePart> part = it->second;
-        renderPart(part);
+    // Instances already drawn from each mesh, which is where its next run starts
+    size_t drawn[PART_MESH_COUNT][MESH_LOD_COUNT] = {};
+    for (TransparentRun& run : runs) {
+        transparentPartMeshes[run.mesh][run.lod]->draw(drawn[run.mesh][run.lod], run.count);
+        drawn[run.mesh][run.lod] += run.count;
     }
 }
 
@@ -235,6 +453,8 @@ static Vector3 FACES[6] = {
     {0, 0, -1},
 };
 
+static const float SURFACE_EXTRAS_DISTANCE = 150.f;
+
 void renderSurfaceExtras() {
     glDepthMask(GL_TRUE);
     glEnable(GL_CULL_FACE);
@@ -244,32 +464,18 @@ void renderSurfaceExtras() {
 
     // Use shader
     ghostShader->use();
-
-    // view/projection transformations
-    glm::mat4 projection = getCameraPerspective();
-    glm::mat4 view = getCameraLookAt();
-    ghostShader->set("projection", projection);
-    ghostShader->set("view", view);
     ghostShader->set("color", glm::vec3(0.87f, 0.87f, 0.0f));
 
-    // Pass in the camera position
-    ghostShader->set("viewPos", getCameraPos());
-
-    for (auto&& inst : gWorkspace()->GetDescendants()) {
-        if (!inst->IsA("Part")) continue;
-        std::shared_ptr<BasePart> part = std::dynamic_pointer_cast<BasePart>(inst);
-        for (int i = 0; i < 6; i++) {
-            NormalId face = (NormalId)i;
-            SurfaceType type = part->GetSurfaceFromFace(face);
-            if (type <= SurfaceType::Universal) continue;
-
-            Vector3 surfaceCenter = part->cframe * (normalFromFace(face) * part->size / 2.f);
+    UniformHandle modelUniform = ghostShader->uniform("model");
+    glm::vec3 cameraPos = getCameraPos();
+    CYLINDER_CHEAP_MESH->bind();
+    for (auto& [part, models] : gWorkspace()->GetRenderScene()->getSurfaceExtras()) {
+        for (const glm::mat4& model : models) {
+            // Too small to make out from further away
+            glm::vec3 offset = cameraPos - glm::vec3(model[3]);
+            if (glm::dot(offset, offset) > SURFACE_EXTRAS_DISTANCE * SURFACE_EXTRAS_DISTANCE) continue;
 
-            glm::mat4 model = CFrame::pointToward(surfaceCenter, part->cframe.Rotation() * normalFromFace(face));
-            model = glm::scale(model, glm::vec3(0.4,0.4,0.4));
-            ghostShader->set("model", model);
-    
-            CYLINDER_CHEAP_MESH->bind();
+            ghostShader->set(modelUniform, model);
             glDrawArrays(GL_TRIANGLES, 0, CYLINDER_CHEAP_MESH->vertexCount);
         }
     }
@@ -307,22 +513,11 @@ void renderHandles() {
     
     // Use shader
     handleShader->use();
+    handleShader->set("numPointLights", 0);
 
-    // view/projection transformations
+    // Needed for the 2d overlay
     glm::mat4 projection = getCameraPerspective();
     glm::mat4 view = getCameraLookAt();
-    handleShader->set("projection", projection);
-    handleShader->set("view", view);
-    handleShader->set("sunLight", DirLight {
-        .direction = glm::vec3(-0.2f, -1.0f, -0.3f),
-        .ambient = glm::vec3(0.2f, 0.2f, 0.2f),
-        .diffuse = glm::vec3(0.5f, 0.5f, 0.5f),
-        .specular = glm::vec3(1.0f, 1.0f, 1.0f),
-    });
-    handleShader->set("numPointLights", 0);
-
-    // Pass in the camera position
-    handleShader->set("viewPos", getCameraPos());
 
     for (auto face : HandleFace::Faces) {
         glm::mat4 model = getHandleCFrame(face);
@@ -355,6 +550,7 @@ void renderHandles() {
         
         drawRect(screenPos.x - 3, screenPos.y - 3, 6, 6, glm::vec3(0, 1, 1));
     }
+    flushRects();
 }
 
 void renderAABB() {
@@ -368,15 +564,6 @@ void renderAABB() {
     // Use shader
     ghostShader->use();
 
-    // view/projection transformations
-    glm::mat4 projection = getCameraPerspective();
-    glm::mat4 view = getCameraLookAt();
-    ghostShader->set("projection", projection);
-    ghostShader->set("view", view);
-
-    // Pass in the camera position
-    ghostShader->set("viewPos", getCameraPos());
-
     ghostShader->set("transparency", 0.5f);
     ghostShader->set("color", glm::vec3(1.f, 0.f, 0.f));
 
@@ -446,19 +633,13 @@ void renderOutlines() {
 
     // Use shader
     outlineShader->use();
-
-    // view/projection transformations
-    glm::mat4 projection = getCameraPerspective();
-    glm::mat4 view = getCameraLookAt();
-    outlineShader->set("projection", projection);
-    outlineShader->set("view", view);
-
-    // Pass in the camera position
-    outlineShader->set("viewPos", getCameraPos());
     outlineShader->set("thickness", 0.4f);
 
     outlineShader->set("color", glm::vec3(0.204, 0.584, 0.922));
 
+    UniformHandle modelUniform = outlineShader->uniform("model");
+    UniformHandle scaleUniform = outlineShader->uniform("scale");
+
     glm::vec3 min, max;
     bool first = true;
 
@@ -477,8 +658,8 @@ void renderOutlines() {
 
         glm::mat4 model = part->cframe;
         model = glm::scale(model, (glm::vec3)part->size + glm::vec3(0.2));
-        outlineShader->set("model", model);
-        outlineShader->set("scale", part->size + glm::vec3(0.1));
+        outlineShader->set(modelUniform, model);
+        outlineShader->set(scaleUniform, part->size + glm::vec3(0.1));
 
         OUTLINE_MESH->bind();
         glDrawArrays(GL_TRIANGLES, 0, OUTLINE_MESH->vertexCount);
@@ -511,15 +692,6 @@ void renderSelectionAssembly() {
 
     // Use shader
     outlineShader->use();
-
-    // view/projection transformations
-    glm::mat4 projection = getCameraPerspective();
-    glm::mat4 view = getCameraLookAt();
-    outlineShader->set("projection", projection);
-    outlineShader->set("view", view);
-
-    // Pass in the camera position
-    outlineShader->set("viewPos", getCameraPos());
     outlineShader->set("thickness", 0.4f);
 
     outlineShader->set("color", glm::vec3(1.f, 0.f, 0.f));
@@ -546,43 +718,32 @@ void renderRotationArcs() {
     glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
     // Use shader
-    handleShader->use();
-
-    handleShader->set("sunLight", DirLight {
-        .direction = glm::vec3(-0.2f, -1.0f, -0.3f),
-        .ambient = glm::vec3(0.2f, 0.2f, 0.2f),
-        .diffuse = glm::vec3(0.5f, 0.5f, 0.5f),
-        .specular = glm::vec3(1.0f, 1.0f, 1.0f),
-    });
-
-    // view/projection transformations
-    glm::mat4 projection = getCameraPerspective();
-    glm::mat4 view = getCameraLookAt();
-    handleShader->set("projection", projection);
-    handleShader->set("view", view);
-
-    // Pass in the camera position
-    handleShader->set("viewPos", getCameraPos());
+    torusShader->use();
+    torusShader->set("numPointLights", 0);
 
     PartAssembly assembly = PartAssembly::FromSelection(gDataModel->GetService<Selection>());
     if (assembly.size() == Vector3::ZERO) return; // No parts are selected
 
+    float radius = glm::max(assembly.size().X(), assembly.size().Y(), assembly.size().Z()) / 2.f + 2.f;
+    torusShader->set("outerRadius", radius);
+    torusShader->set("innerRadius", 0.05f);
+
+    UniformHandle modelUniform = torusShader->uniform("model");
+    UniformHandle materialDiffuseUniform = torusShader->uniform("material.diffuse");
+    UniformHandle normalMatrixUniform = torusShader->uniform("normalMatrix");
+    torusShader->set("material.specular", glm::vec3(0.5f, 0.5f, 0.5f));
+    torusShader->set("material.shininess", 16.0f);
+
+    TORUS_MESH->bind();
     for (HandleFace face : HandleFace::Faces) {
         if (glm::any(glm::lessThan(face.normal, glm::vec3(0)))) continue;
         glm::mat4 model = assembly.assemblyOrigin() * CFrame(glm::vec3(0), face.normal, glm::vec3(0, 1.01, 0.1));
-        handleShader->set("model", model);
-
-        float radius = glm::max(assembly.size().X(), assembly.size().Y(), assembly.size().Z()) / 2.f + 2.f;
-
-        handleShader->set("material", Material {
-            .diffuse = glm::abs(face.normal),
-            .specular = glm::vec3(0.5f, 0.5f, 0.5f),
-            .shininess = 16.0f,
-        });
+        torusShader->set(modelUniform, model);
+        torusShader->set(materialDiffuseUniform, glm::abs(face.normal));
         glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
-        handleShader->set("normalMatrix", normalMatrix);
+        torusShader->set(normalMatrixUniform, normalMatrix);
 
-        genTorus(radius, 0.05f, 20, 20);
+        glDrawArrays(GL_TRIANGLES, 0, TORUS_MESH->vertexCount);
     }
 }
 
@@ -594,34 +755,21 @@ void renderDebugCFrames() {
     
     // Use shader
     handleShader->use();
-
-    // view/projection transformations
-    glm::mat4 projection = getCameraPerspective();
-    glm::mat4 view = getCameraLookAt();
-    handleShader->set("projection", projection);
-    handleShader->set("view", view);
-    handleShader->set("sunLight", DirLight {
-        .direction = glm::vec3(-0.2f, -1.0f, -0.3f),
-        .ambient = glm::vec3(0.2f, 0.2f, 0.2f),
-        .diffuse = glm::vec3(0.5f, 0.5f, 0.5f),
-        .specular = glm::vec3(1.0f, 1.0f, 1.0f),
-    });
     handleShader->set("numPointLights", 0);
 
-    // Pass in the camera position
-    handleShader->set("viewPos", getCameraPos());
+    UniformHandle modelUniform = handleShader->uniform("model");
+    UniformHandle materialDiffuseUniform = handleShader->uniform("material.diffuse");
+    UniformHandle normalMatrixUniform = handleShader->uniform("normalMatrix");
+    handleShader->set("material.specular", glm::vec3(0.5f, 0.5f, 0.5f));
+    handleShader->set("material.shininess", 16.0f);
 
     for (auto& [frame, color] : DEBUG_CFRAMES) {
         glm::mat4 model = frame;
         model = glm::scale(model, glm::vec3(0.5, 0.5, 1.5));
-        handleShader->set("model", model);
-        handleShader->set("material", Material {
-            .diffuse = color,
-            .specular = glm::vec3(0.5f, 0.5f, 0.5f),
-            .shininess = 16.0f,
-        });
+        handleShader->set(modelUniform, model);
+        handleShader->set(materialDiffuseUniform, (glm::vec3)color);
         glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
-        handleShader->set("normalMatrix", normalMatrix);
+        handleShader->set(normalMatrixUniform, normalMatrix);
 
         ARROW_MESH->bind();
         glDrawArrays(GL_TRIANGLES, 0, ARROW_MESH->vertexCount);
@@ -662,6 +810,26 @@ void renderMessages() {
             drawText(sansSerif, message->text, ((float)viewportWidth - strokedTextWidth) / 2, ((float)viewportHeight - sansSerif->height) / 2, 1.f, glm::vec3(1), false);
         }
     }
+
+    // All the text goes over all the backgrounds
+    flushRects();
+    flushText();
+}
+
+// Uploads the camera and lighting shared by all shaders for this frame
+static void updateFrameBlocks() {
+    cameraBlock->upload(CameraBlock {
+        .projection = getCameraPerspective(),
+        .view = getCameraLookAt(),
+        .viewPos = getCameraPos(),
+    });
+
+    lightBlock->upload(LightBlock {
+        .direction = glm::vec3(-0.2f, -1.0f, -0.3f),
+        .ambient = glm::vec3(0.2f, 0.2f, 0.2f),
+        .diffuse = glm::vec3(0.5f, 0.5f, 0.5f),
+        .specular = glm::vec3(1.0f, 1.0f, 1.0f),
+    });
 }
 
 tu_time_t renderTime;
@@ -673,6 +841,7 @@ void render() {
     // For some reason this is unset by QPainter, so we override it here
     glEnable(GL_MULTISAMPLE);
 
+    updateFrameBlocks();
     renderSkyBox();
     renderHandles();
     renderDebugCFrames();
@@ -689,6 +858,7 @@ void render() {
     // TODO: Make this a debug flag
     // renderAABB();
 
+    streamBuffer->endFrame();
     renderTime = tu_clock_micros() - startTime;
 
     identityShader->use();
@@ -699,27 +869,56 @@ void render() {
     glBindBuffer(GL_ARRAY_BUFFER,0);
 }
 
-void drawRect(int x, int y, int width, int height, glm::vec4 color) {
-    // GL_CULL_FACE has to be disabled as we are flipping the order of the vertices here, besides we don't really care about it
-    glDisable(GL_CULL_FACE);
-    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+// Rects queued by drawRect, as <vec2 pos, vec4 color>
+static std::vector<float> rectVertices;
+static unsigned int rectVAO;
+
+static void initRects() {
+    glGenVertexArrays(1, &rectVAO);
+    glBindVertexArray(rectVAO);
+    // Pointed at the stream buffer in flushRects
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+}
 
+void drawRect(int x, int y, int width, int height, glm::vec4 color) {
     // Multiply color
     float a = color.a;
     color *= a;
     color.a = a;
 
-    glm::mat4 model(1.0f); // Same applies to this VV
+    float x0 = x, y0 = y, x1 = x + width, y1 = y + height;
+    rectVertices.insert(rectVertices.end(), {
+        x0, y0,   color.r, color.g, color.b, color.a,
+        x1, y0,   color.r, color.g, color.b, color.a,
+        x1, y1,   color.r, color.g, color.b, color.a,
+
+        x1, y1,   color.r, color.g, color.b, color.a,
+        x0, y1,   color.r, color.g, color.b, color.a,
+        x0, y0,   color.r, color.g, color.b, color.a,
+    });
+}
+
+void flushRects() {
+    if (rectVertices.empty()) return;
+
+    // GL_CULL_FACE has to be disabled as we are flipping the order of the vertices here, besides we don't really care about it
+    glDisable(GL_CULL_FACE);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
     // Make sure to cast these to floats, as mat4<i> is a different type that is not compatible
     glm::mat4 proj = glm::ortho(0.f, (float)viewportWidth, (float)viewportHeight, 0.f, -1.f, 1.f);
-    model = glm::translate(model, glm::vec3(x, y, 0.0f));
-    model = glm::scale(model, glm::vec3(width, height, 1.0f));
     generic2dShader->use();
-    generic2dShader->set("aColor", color);
     generic2dShader->set("projection", proj);
-    generic2dShader->set("model", model);
-    rect2DMesh->bind();
-    glDrawArrays(GL_TRIANGLES, 0, rect2DMesh->vertexCount);
+
+    glBindVertexArray(rectVAO);
+    size_t offset = streamBuffer->push(rectVertices.data(), rectVertices.size() * sizeof(float));
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)offset);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(offset + 2 * sizeof(float)));
+    glDrawArrays(GL_TRIANGLES, 0, rectVertices.size() / 6);
+
+    rectVertices.clear();
 }
 
 void setViewport(int width, int height) {
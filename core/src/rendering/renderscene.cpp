@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <glm/common.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/matrix.hpp>
+
+#include "datatypes/cframe.h"
+#include "datatypes/vector.h"
+#include "enum/part.h"
+#include "enum/surface.h"
+#include "objects/part/part.h"
+#include "objects/part/wedgepart.h"
+
+#include "renderscene.h"
+
+static PartMeshType partMeshType(BasePart* part) {
+    if (part->IsA<WedgePart>()) return PART_MESH_WEDGE;
+
+    PartType shape = part->IsA<Part>() ? static_cast<Part*>(part)->shape : PartType::Block;
+    if (shape == PartType::Ball) return PART_MESH_SPHERE;
+    if (shape == PartType::Cylinder) return PART_MESH_CYLINDER;
+    return PART_MESH_CUBE;
+}
+
+static PartInstance partInstance(BasePart* part) {
+    Vector3 size = part->GetEffectiveSize();
+    glm::mat4 model = glm::scale((glm::mat4)part->cframe, (glm::vec3)size);
+
+    return PartInstance {
+        .model = model,
+        .normalMatrix = glm::mat3(glm::transpose(glm::inverse(model))),
+        .color = part->color,
+        .material = glm::vec2(part->transparency, part->reflectance),
+        .size = (glm::vec3)size,
+        .surfaces = {
+            (int)part->rightSurface, (int)part->topSurface, (int)part->backSurface,
+            (int)part->leftSurface, (int)part->bottomSurface, (int)part->frontSurface,
+        },
+    };
+}
+
+// Bounding box of the unit mesh transformed by the model matrix
+static void instanceBounds(const glm::mat4& model, glm::vec3& center, glm::vec3& extents) {
+    center = glm::vec3(model[3]);
+    extents = (glm::abs(glm::vec3(model[0])) + glm::abs(glm::vec3(model[1])) + glm::abs(glm::vec3(model[2]))) * 0.5f;
+}
+
+void RenderBucket::push_back(BasePart* part, const PartInstance& instance) {
+    glm::vec3 center, extents;
+    instanceBounds(instance.model, center, extents);
+
+    parts.push_back(part);
+    instances.push_back(instance);
+    bounds.push_back(center, extents);
+    markDirty(parts.size() - 1);
+}
+
+void RenderBucket::set(size_t index, const PartInstance& instance) {
+    glm::vec3 center, extents;
+    instanceBounds(instance.model, center, extents);
+
+    instances[index] = instance;
+    bounds.set(index, center, extents);
+    markDirty(index);
+}
+
+void RenderBucket::swapRemove(size_t index) {
+    size_t last = parts.size() - 1;
+    if (index != last) {
+        parts[index] = parts[last];
+        instances[index] = instances[last];
+        bounds.copy(last, index);
+        markDirty(index);
+    }
+
+    parts.pop_back();
+    instances.pop_back();
+    bounds.pop_back();
+
+    dirtyLast = std::min(dirtyLast, parts.size());
+    if (dirtyFirst >= dirtyLast)
+        clearDirty();
+}
+
+void RenderBucket::markDirty(size_t index) {
+    if (dirtyFirst == dirtyLast) {
+        dirtyFirst = index, dirtyLast = index + 1;
+        return;
+    }
+
+    dirtyFirst = std::min(dirtyFirst, index);
+    dirtyLast = std::max(dirtyLast, index + 1);
+}
+
+const float CHUNK_SIZE = 64.f;
+
+static uint64_t chunkKey(Vector3 position) {
+    // 21 bits per axis, which is far more than the world ever spans
+    auto axis = [](float x) { return (uint64_t)((int64_t)std::floor(x / CHUNK_SIZE) & 0x1FFFFF); };
+    return axis(position.X()) | axis(position.Y()) << 21 | axis(position.Z()) << 42;
+}
+
+static void markChunkChanged(RenderChunk* chunk) {
+    chunk->changed = true;
+    chunk->boundsDirty = true;
+}
+
+RenderBucket& RenderScene::bucketOf(BasePart* part, RenderChunk*& chunk) {
+    PartMeshType mesh = partMeshType(part);
+    chunk = nullptr;
+
+    if (part->transparency > 0.00001) return transparentBuckets[mesh];
+    if (!part->anchored) return opaqueBuckets[mesh];
+
+    uint64_t key = chunkKey(part->position());
+    chunk = &chunks[key];
+    chunk->key = key;
+    return chunk->buckets[mesh];
+}
+
+void RenderScene::insert(BasePart* part) {
+    RenderChunk* chunk;
+    RenderBucket& bucket = bucketOf(part, chunk);
+    bucket.push_back(part, partInstance(part));
+
+    if (chunk != nullptr) {
+        chunk->size++;
+        markChunkChanged(chunk);
+    }
+
+    locations[part] = Location { .bucket = &bucket, .index = bucket.parts.size() - 1, .chunk = chunk };
+}
+
+void RenderScene::erase(Location& location) {
+    RenderBucket& bucket = *location.bucket;
+    bucket.swapRemove(location.index);
+
+    // Another part was moved into its place
+    if (location.index < bucket.parts.size())
+        locations[bucket.parts[location.index]].index = location.index;
+
+    RenderChunk* chunk = location.chunk;
+    if (chunk == nullptr) return;
+
+    markChunkChanged(chunk);
+    if (--chunk->size == 0)
+        chunks.erase(chunk->key);
+}
+
+void RenderScene::updateSurfaceExtras(BasePart* part) {
+    if (!part->IsA("Part")) return;
+
+    std::vector<glm::mat4> models;
+    for (int i = 0; i < 6; i++) {
+        NormalId face = (NormalId)i;
+        SurfaceType type = part->GetSurfaceFromFace(face);
+        if (type <= SurfaceType::Universal) continue;
+
+        Vector3 surfaceCenter = part->cframe * (normalFromFace(face) * part->size / 2.f);
+
+        glm::mat4 model = CFrame::pointToward(surfaceCenter, part->cframe.Rotation() * normalFromFace(face));
+        models.push_back(glm::scale(model, glm::vec3(0.4,0.4,0.4)));
+    }
+
+    if (models.empty())
+        surfaceExtras.erase(part);
+    else
+        surfaceExtras[part] = std::move(models);
+}
+
+void RenderScene::addPart(BasePart* part) {
+    if (locations.count(part) > 0) return markDirty(part);
+
+    insert(part);
+    updateSurfaceExtras(part);
+}
+
+void RenderScene::removePart(BasePart* part) {
+    auto it = locations.find(part);
+    if (it == locations.end()) return;
+
+    erase(it->second);
+    locations.erase(it);
+    surfaceExtras.erase(part);
+}
+
+void RenderScene::markDirty(BasePart* part) {
+    auto it = locations.find(part);
+    if (it == locations.end() || it->second.queued) return;
+
+    it->second.queued = true;
+    queue.push_back(part);
+}
+
+void RenderScene::update() {
+    for (BasePart* part : queue) {
+        // Removed since being queued
+        auto it = locations.find(part);
+        if (it == locations.end() || !it->second.queued) continue;
+        Location& location = it->second;
+        location.queued = false;
+
+        // The part changed transparency, shape or chunk, and has to be moved to another bucket
+        RenderChunk* chunk;
+        if (&bucketOf(part, chunk) != location.bucket) {
+            erase(location);
+            insert(part);
+        } else {
+            location.bucket->set(location.index, partInstance(part));
+            if (chunk != nullptr) markChunkChanged(chunk);
+        }
+
+        updateSurfaceExtras(part);
+    }
+
+    queue.clear();
+
+    for (auto& [key, chunk] : chunks) {
+        if (!chunk.boundsDirty) continue;
+        chunk.boundsDirty = false;
+
+        chunk.min = glm::vec3(std::numeric_limits<float>::infinity());
+        chunk.max = -chunk.min;
+        for (RenderBucket& bucket : chunk.buckets) {
+            const AABBArray& bounds = bucket.bounds;
+            for (size_t i = 0; i < bounds.size(); i++) {
+                glm::vec3 center(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+                glm::vec3 extents(bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+                chunk.min = glm::min(chunk.min, center - extents);
+                chunk.max = glm::max(chunk.max, center + extents);
+            }
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float3.hpp>
+#include <unordered_map>
+#include <vector>
+#include "rendering/frustum.h"
+#include "rendering/instancedmesh.h"
+
+class BasePart;
+
+enum PartMeshType {
+    PART_MESH_CUBE,
+    PART_MESH_WEDGE,
+    PART_MESH_SPHERE,
+    PART_MESH_CYLINDER,
+    PART_MESH_COUNT,
+};
+
+// Parts drawn with the same mesh, with their instance data laid out ready to be uploaded
+struct RenderBucket {
+    std::vector<BasePart*> parts;
+    std::vector<PartInstance> instances;
+    AABBArray bounds;
+    // Range of instances changed since the bucket was last uploaded
+    size_t dirtyFirst = 0, dirtyLast = 0;
+
+    void push_back(BasePart* part, const PartInstance& instance);
+    void set(size_t index, const PartInstance& instance);
+    // Moves the last part into the gap, so that the instances stay contiguous
+    void swapRemove(size_t index);
+
+    void markDirty(size_t index);
+    inline void clearDirty() { dirtyFirst = dirtyLast = 0; }
+};
+
+// Anchored opaque parts within one cube of the world. These rarely change, so the renderer keeps
+// them on the GPU as is and draws the whole chunk at once, only uploading it again when it changed
+struct RenderChunk {
+    uint64_t key;
+    RenderBucket buckets[PART_MESH_COUNT];
+    size_t size = 0;
+    // Bounds of all the parts in the chunk
+    glm::vec3 min, max;
+    bool boundsDirty = true;
+    // Set when a part in the chunk changes, and cleared by the renderer once it has uploaded it
+    bool changed = true;
+};
+
+// Render data of the parts in a workspace. Rather than being gathered every frame, it is only
+// recomputed for parts that are marked dirty, either by a property change or a physics step
+class RenderScene {
+    struct Location {
+        RenderBucket* bucket;
+        size_t index;
+        RenderChunk* chunk = nullptr;
+        bool queued = false;
+    };
+
+    RenderBucket opaqueBuckets[PART_MESH_COUNT];
+    RenderBucket transparentBuckets[PART_MESH_COUNT];
+    std::unordered_map<uint64_t, RenderChunk> chunks;
+    std::unordered_map<BasePart*, Location> locations;
+    std::vector<BasePart*> queue;
+    // Models of the decorations drawn on hinge and motor surfaces
+    std::unordered_map<BasePart*, std::vector<glm::mat4>> surfaceExtras;
+
+    // Creates the chunk the part belongs in if there isn't one yet
+    RenderBucket& bucketOf(BasePart* part, RenderChunk*& chunk);
+    void insert(BasePart* part);
+    void erase(Location& location);
+    void updateSurfaceExtras(BasePart* part);
+public:
+    void addPart(BasePart* part);
+    void removePart(BasePart* part);
+    // Queues the part to be recomputed by the next update. Parts outside of the scene are ignored
+    void markDirty(BasePart* part);
+    void update();
+
+    // Buckets of the parts that aren't in a chunk
+    inline RenderBucket& getBucket(PartMeshType mesh, bool transparent) { return transparent ? transparentBuckets[mesh] : opaqueBuckets[mesh]; }
+    inline std::unordered_map<uint64_t, RenderChunk>& getChunks() { return chunks; }
+    inline const std::unordered_map<BasePart*, std::vector<glm::mat4>>& getSurfaceExtras() { return surfaceExtras; }
+    inline size_t size() { return locations.size(); }
+};
@@ -5,6 +5,7 @@
 #include "logger.h"
 #include "panic.h"
 #include "rendering/assets.h"
+#include "rendering/uniformbuffer.h"
 #include "shader.h"
 
 std::string getContents(std::string filePath) {
@@ -54,6 +55,48 @@ Shader::Shader(std::string vertexShaderPath, std::string fragmentShaderPath) {
 
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+
+    cacheUniformLocations();
+    bindUniformBlock("CameraBlock", CAMERA_BLOCK_BINDING);
+    bindUniformBlock("LightBlock", LIGHT_BLOCK_BINDING);
+}
+
+void Shader::cacheUniformLocations() {
+    int count;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+
+    char name[256];
+    for (int i = 0; i < count; i++) {
+        GLsizei length;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform(id, i, sizeof(name), &length, &size, &type, name);
+
+        // Members of uniform blocks have no location
+        int location = glGetUniformLocation(id, name);
+        if (location == -1) continue;
+
+        std::string key(name, length);
+        uniformLocations[key] = location;
+
+        // Arrays are only listed by their first element, so add the rest of them
+        if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0) {
+            std::string base = key.substr(0, key.size() - 3);
+            uniformLocations[base] = location;
+
+            for (int j = 1; j < size; j++) {
+                std::string elementKey = base + "[" + std::to_string(j) + "]";
+                uniformLocations[elementKey] = glGetUniformLocation(id, elementKey.c_str());
+            }
+        }
+    }
+}
+
+void Shader::bindUniformBlock(const char* name, unsigned int binding) {
+    unsigned int index = glGetUniformBlockIndex(id, name);
+    if (index == GL_INVALID_INDEX) return;
+
+    glUniformBlockBinding(id, index, binding);
 }
 
 Shader::~Shader() {
@@ -64,12 +107,42 @@ void Shader::use() {
     glUseProgram(id);
 }
 
+UniformHandle Shader::uniform(std::string key) {
+    auto it = uniformLocations.find(key);
+    if (it == uniformLocations.end()) return {};
+    return { it->second };
+}
+
+void Shader::set(UniformHandle uniform, int value) {
+    glUniform1i(uniform.location, value);
+}
+
+void Shader::set(UniformHandle uniform, float value) {
+    glUniform1f(uniform.location, value);
+}
+
+void Shader::set(UniformHandle uniform, glm::vec3 value) {
+    glUniform3f(uniform.location, value.x, value.y, value.z);
+}
+
+void Shader::set(UniformHandle uniform, glm::vec4 value) {
+    glUniform4f(uniform.location, value.x, value.y, value.z, value.w);
+}
+
+void Shader::set(UniformHandle uniform, glm::mat3 value) {
+    glUniformMatrix3fv(uniform.location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::set(UniformHandle uniform, glm::mat4 value) {
+    glUniformMatrix4fv(uniform.location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
 void Shader::set(std::string key, int value) {
-    glUniform1i(glGetUniformLocation(id, key.c_str()), value);
+    set(uniform(key), value);
 }
 
 void Shader::set(std::string key, float value) {
-    glUniform1f(glGetUniformLocation(id, key.c_str()), value);
+    set(uniform(key), value);
 }
 
 void Shader::set(std::string key, Material value) {
@@ -97,19 +170,19 @@ void Shader::set(std::string key, PointLight value) {
 }
 
 void Shader::set(std::string key, glm::vec3 value) {
-    glUniform3f(glGetUniformLocation(id, key.c_str()), value.x, value.y, value.z);
+    set(uniform(key), value);
 }
 
 void Shader::set(std::string key, glm::vec4 value) {
-    glUniform4f(glGetUniformLocation(id, key.c_str()), value.x, value.y, value.z, value.w);
+    set(uniform(key), value);
 }
 
 void Shader::set(std::string key, glm::mat3 value) {
-    glUniformMatrix3fv(glGetUniformLocation(id, key.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    set(uniform(key), value);
 }
 
 void Shader::set(std::string key, glm::mat4 value) {
-    glUniformMatrix4fv(glGetUniformLocation(id, key.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    set(uniform(key), value);
 }
 
 int Shader::getAttribute(std::string key) {
@@ -2,17 +2,38 @@
 #include <glm/ext/vector_float3.hpp>
 #include <glm/fwd.hpp>
 #include <string>
+#include <unordered_map>
 #include "material.h"
 #include "light.h"
 
+// Location of a uniform in a specific shader, looked up once through Shader::uniform
+struct UniformHandle {
+    int location = -1;
+};
+
 class Shader {
     unsigned int id;
+    // Filled in once the program is linked
+    std::unordered_map<std::string, int> uniformLocations;
+
+    void cacheUniformLocations();
+    void bindUniformBlock(const char* name, unsigned int binding);
 
 public:
     void use();
     Shader(std::string vertexShaderPath, std::string fragmentShaderPath);
     ~Shader();
 
+    // Returns a handle to the uniform, which is invalid (and ignored when set) if the shader has no such uniform
+    UniformHandle uniform(std::string key);
+
+    void set(UniformHandle uniform, int value);
+    void set(UniformHandle uniform, float value);
+    void set(UniformHandle uniform, glm::vec3 value);
+    void set(UniformHandle uniform, glm::vec4 value);
+    void set(UniformHandle uniform, glm::mat3 value);
+    void set(UniformHandle uniform, glm::mat4 value);
+
     void set(std::string key, int value);
     void set(std::string key, float value);
     void set(std::string key, Material value);
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cstring>
+#include <glad/gl.h>
+
+#include "streambuffer.h"
+
+// Offsets are aligned so that any vertex attribute can start at them
+const uint64_t STREAM_ALIGNMENT = 16;
+
+StreamBuffer::StreamBuffer(size_t capacity) : capacity(capacity) {
+    glGenBuffers(1, &VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (Fence& fence : fences)
+        glDeleteSync((GLsync)fence.sync);
+    glDeleteBuffers(1, &VBO);
+}
+
+void StreamBuffer::orphan(size_t minCapacity) {
+    // None of the old frames are in this storage
+    for (Fence& fence : fences)
+        glDeleteSync((GLsync)fence.sync);
+    fences.clear();
+
+    capacity = std::max(capacity, minCapacity);
+    glBufferData(GL_ARRAY_BUFFER, capacity, NULL, GL_STREAM_DRAW);
+    written = frameStart = 0;
+}
+
+// Waits for every frame whose data lies in the part of the buffer that writing up to end overwrites
+void StreamBuffer::waitFor(uint64_t end) {
+    while (!fences.empty() && fences.front().start + capacity < end) {
+        GLsync sync = (GLsync)fences.front().sync;
+        while (glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000) == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(sync);
+        fences.pop_front();
+    }
+}
+
+size_t StreamBuffer::push(const void* data, size_t size) {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    uint64_t start = (written + STREAM_ALIGNMENT - 1) / STREAM_ALIGNMENT * STREAM_ALIGNMENT;
+    // The data can't be split across the end of the buffer, so skip ahead to the start of it
+    if (start % capacity + size > capacity)
+        start = (start / capacity + 1) * capacity;
+
+    // This frame alone doesn't fit in the buffer
+    if (start + size - frameStart > capacity) {
+        orphan(size * 2);
+        start = 0;
+    }
+
+    waitFor(start + size);
+
+    size_t offset = start % capacity;
+    void* dest = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dest != NULL) {
+        memcpy(dest, data, size);
+        // Contents become undefined if the storage was lost while mapped, in which case it is rewritten below
+        if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE) {
+            written = start + size;
+            return offset;
+        }
+    }
+
+    // Mapping failed, fall back to fresh storage, which never has to be waited on
+    orphan(size * 2);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+    written = size;
+    return 0;
+}
+
+void StreamBuffer::endFrame() {
+    if (written == frameStart) return;
+
+    fences.push_back(Fence { frameStart, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    frameStart = written;
+}
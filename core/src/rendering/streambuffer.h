@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+// Ring buffer for vertex data that is generated every frame. Each push is written past the previous
+// one without synchronizing, and fences mark which frames the GPU may still be reading from, so that
+// they are only overwritten once it is done with them
+class StreamBuffer {
+    struct Fence {
+        // Position the frame started writing at
+        uint64_t start;
+        void* sync;
+    };
+
+    unsigned int VBO;
+    size_t capacity;
+    // Bytes written since the storage was allocated. The offset in the buffer is this modulo the capacity
+    uint64_t written = 0;
+    uint64_t frameStart = 0;
+    std::deque<Fence> fences;
+
+    // Replaces the storage, leaving the old one to the driver until the GPU is done with it
+    void orphan(size_t minCapacity);
+    void waitFor(uint64_t end);
+
+public:
+    StreamBuffer(size_t capacity);
+    ~StreamBuffer();
+
+    // Copies the data into the buffer and returns its offset. The buffer is left bound to
+    // GL_ARRAY_BUFFER, and the data has to be drawn before anything else is pushed
+    size_t push(const void* data, size_t size);
+    // Fences off everything pushed this frame
+    void endFrame();
+};
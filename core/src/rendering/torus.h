@@ -1,11 +1,14 @@
 #pragma once
 
+class Mesh;
+
 /*
-    Generates a torus made of circles extruded into cylinders and spun around the origin
+    Generates a torus made of circles extruded into cylinders and spun around the Z axis
+
+    The radii are left for torus.vs to apply, so that one mesh can be drawn at any size. Each vertex
+    holds the direction from the origin to the center of its circle in place of its position
 
-    float outerRadius - The radius of the "circle" from the origin at which the center of the cylinders lie
-    float innerRadius - The radius of the cylinders
     int tubeSides - Number of vertices in each circle
     int ringSides - How many cylinder circles to draw around the torus
 */
-void genTorus(float outerRadius, float innerRadius, int tubeSides, int ringSides);
\ No newline at end of file
+Mesh* genTorusMesh(int tubeSides, int ringSides);
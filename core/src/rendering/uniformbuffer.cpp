@@ -0,0 +1,22 @@
+#include <glad/gl.h>
+
+#include "uniformbuffer.h"
+
+UniformBuffer::UniformBuffer(unsigned int binding, size_t size) : size(size) {
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, size, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, UBO);
+}
+
+UniformBuffer::~UniformBuffer() {
+    glDeleteBuffers(1, &UBO);
+}
+
+void UniformBuffer::uploadData(const void* data) {
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
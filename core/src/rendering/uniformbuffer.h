@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/ext/vector_float3.hpp>
+
+// Binding points of the uniform blocks shared between shaders. Shaders are
+// bound to these by block name when they are linked
+const unsigned int CAMERA_BLOCK_BINDING = 0;
+const unsigned int LIGHT_BLOCK_BINDING = 1;
+
+// std140 layouts, matching the blocks declared in the shaders
+struct CameraBlock {
+    glm::mat4 projection;
+    glm::mat4 view;
+    alignas(16) glm::vec3 viewPos;
+};
+
+struct LightBlock {
+    // sunLight
+    alignas(16) glm::vec3 direction;
+    alignas(16) glm::vec3 ambient;
+    alignas(16) glm::vec3 diffuse;
+    alignas(16) glm::vec3 specular;
+};
+
+// Buffer backing a uniform block, updated once per frame and read by every shader bound to it
+class UniformBuffer {
+    unsigned int UBO;
+    size_t size;
+
+    void uploadData(const void* data);
+
+public:
+    UniformBuffer(unsigned int binding, size_t size);
+    ~UniformBuffer();
+
+    template <typename T> inline void upload(const T& block) { uploadData(&block); }
+};
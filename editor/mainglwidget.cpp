@@ -141,11 +141,13 @@ void MainGLWidget::handleObjectDrag(QMouseEvent* evt) {
 
     QPoint position = evt->pos();
 
-    initialAssembly.SetCollisionsEnabled(false);
     auto camera = gWorkspace()->GetCamera();
     glm::vec3 pointDir = camera->GetScreenDirection(glm::vec2(position.x(), position.y()), glm::vec2(width(), height()));
-    std::optional<const RaycastResult> rayHit = gWorkspace()->CastRayNearest(gWorkspace()->GetCamera()->cframe.Position(), pointDir, 50000);
-    initialAssembly.SetCollisionsEnabled(true);
+
+    // Look past the parts being dragged
+    PhysQueryParams params;
+    params.exclude.assign(initialAssembly.GetParts().begin(), initialAssembly.GetParts().end());
+    std::optional<const RaycastResult> rayHit = gWorkspace()->CastRayNearest(gWorkspace()->GetCamera()->cframe.Position(), pointDir, 50000, params);
     
     if (!rayHit) return;
 
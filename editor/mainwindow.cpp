@@ -22,6 +22,7 @@
 #include <qlabel.h>
 #include <qmessagebox.h>
 #include <qmimedata.h>
+#include <qprogressdialog.h>
 #include <qnamespace.h>
 #include <qstylefactory.h>
 #include <qstylehints.h>
@@ -222,7 +223,7 @@ void MainWindow::refreshRecentsMenu() {
                 return;
             }
 
-            std::shared_ptr<DataModel> newModel = DataModel::LoadFromFile(item.toStdString());
+            std::shared_ptr<DataModel> newModel = loadPlace(item.toStdString());
             editModeDataModel = newModel;
             gDataModel = newModel;
             newModel->Init();
@@ -401,7 +402,7 @@ void MainWindow::connectActionHandlers() {
     });
 
     connect(ui->actionSaveAs, &QAction::triggered, this, [&]() {
-        std::optional<std::string> path = openFileDialog("Openblocks Level (*.obl)", ".obl", QFileDialog::AcceptSave, QString::fromStdString("Save as " + editModeDataModel->name));
+        std::optional<std::string> path = openFileDialog("Openblocks Level (*.obl *.oblb)", ".obl", QFileDialog::AcceptSave, QString::fromStdString("Save as " + editModeDataModel->name));
         if (!path || path == "") return;
 
         editModeDataModel->SaveToFile(path);
@@ -409,14 +410,14 @@ void MainWindow::connectActionHandlers() {
     });
 
     connect(ui->actionOpen, &QAction::triggered, this, [&]() {
-        std::optional<std::string> path = openFileDialog("Openblocks Level (*.obl)", ".obl", QFileDialog::AcceptOpen);
+        std::optional<std::string> path = openFileDialog("Openblocks Level (*.obl *.oblb)", ".obl", QFileDialog::AcceptOpen);
         if (!path || path == "") return;
         
         // // See TODO: Also remove this (the reaso
         // ui->mainWidget->lastPart = Part::New();
         
         // simulationInit();
-        std::shared_ptr<DataModel> newModel = DataModel::LoadFromFile(path.value());
+        std::shared_ptr<DataModel> newModel = loadPlace(path.value());
         editModeDataModel = newModel;
         gDataModel = newModel;
         newModel->Init();
@@ -660,7 +661,7 @@ void MainWindow::openFile(std::string path) {
     }
     #endif
 
-    std::shared_ptr<DataModel> newModel = DataModel::LoadFromFile(path);
+    std::shared_ptr<DataModel> newModel = loadPlace(path);
     editModeDataModel = newModel;
     gDataModel = newModel;
     newModel->Init();
@@ -727,6 +728,18 @@ std::optional<std::string> MainWindow::openFileDialog(QString filter, QString de
     return dialog.selectedFiles().front().toStdString();
 }
 
+std::shared_ptr<DataModel> MainWindow::loadPlace(std::string path) {
+    QProgressDialog progressDialog(QString::fromStdString("Loading " + path + "..."), QString(), 0, 1000, this);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    // Don't flash a dialog for places that load quickly
+    progressDialog.setMinimumDuration(500);
+
+    return DataModel::LoadFromFile(path, [&](size_t bytesRead, size_t totalBytes) {
+        if (totalBytes > 0)
+            progressDialog.setValue(bytesRead * 1000 / totalBytes);
+    });
+}
+
 ScriptDocument* MainWindow::findScriptWindow(std::shared_ptr<Script> script) {
     for (QMdiSubWindow* window : ui->mdiArea->subWindowList()) {
         ScriptDocument* doc = dynamic_cast<ScriptDocument*>(window);
@@ -14,6 +14,8 @@
 #include <qfiledialog.h>
 #include <qmdisubwindow.h>
 
+class DataModel;
+
 enum SelectedTool {
     TOOL_SELECT,
     TOOL_MOVE,
@@ -85,5 +87,7 @@ private:
     ScriptDocument* findScriptWindow(std::shared_ptr<Script>);
     
     std::optional<std::string> openFileDialog(QString filter, QString defaultExtension, QFileDialog::AcceptMode acceptMode, QString title = "");
+    // Loads a place file, showing a progress bar while it is read
+    std::shared_ptr<DataModel> loadPlace(std::string path);
 };
 #endif // MAINWINDOW_H
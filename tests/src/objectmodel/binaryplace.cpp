@@ -0,0 +1,62 @@
+#include "objects/datamodel.h"
+#include "objects/binaryplace.h"
+#include "objects/joint/weld.h"
+#include "objects/part/part.h"
+#include "objects/service/workspace.h"
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <memory>
+
+TEST_CASE("Binary place format") {
+    auto root = DataModel::New();
+    root->Init(true);
+    auto workspace = root->GetService<Workspace>();
+
+    auto part0 = Part::New();
+    part0->name = "Part0";
+    part0->size = Vector3(4, 1, 2);
+    part0->color = Color3(0.5, 0.25, 1);
+    part0->anchored = true;
+    part0->shape = PartType::Ball;
+    workspace->AddChild(part0);
+
+    auto part1 = Part::New();
+    part1->name = "Part1";
+    part1->cframe = CFrame(Vector3(1, 2, 3));
+    workspace->AddChild(part1);
+
+    auto weld = Weld::New();
+    weld->name = "Weld";
+    weld->part0 = part0;
+    weld->part1 = part1;
+    part0->AddChild(weld);
+
+    std::string path = (std::filesystem::temp_directory_path() / "obtest_binaryplace.oblb").string();
+    root->SaveToFile(path);
+
+    SECTION("Format is detected from the file") {
+        REQUIRE(isBinaryPlaceFile(path));
+    }
+
+    SECTION("Roundtrip preserves hierarchy, properties and references") {
+        auto loaded = DataModel::LoadFromFile(path);
+        auto loadedWorkspace = loaded->GetService<Workspace>();
+
+        auto loadedPart0 = std::dynamic_pointer_cast<Part>(loadedWorkspace->FindFirstChild("Part0"));
+        auto loadedPart1 = std::dynamic_pointer_cast<Part>(loadedWorkspace->FindFirstChild("Part1"));
+        REQUIRE(loadedPart0 != nullptr);
+        REQUIRE(loadedPart1 != nullptr);
+        REQUIRE(loadedPart0->size == part0->size);
+        REQUIRE(loadedPart0->color == part0->color);
+        REQUIRE(loadedPart0->anchored);
+        REQUIRE(loadedPart0->shape == PartType::Ball);
+        REQUIRE(loadedPart1->cframe == part1->cframe);
+
+        auto loadedWeld = std::dynamic_pointer_cast<Weld>(loadedPart0->FindFirstChild("Weld"));
+        REQUIRE(loadedWeld != nullptr);
+        REQUIRE(loadedWeld->part0.lock() == loadedPart0);
+        REQUIRE(loadedWeld->part1.lock() == loadedPart1);
+    }
+
+    std::filesystem::remove(path);
+}
@@ -1,6 +1,11 @@
+#include "objects/camera.h"
 #include "objects/datamodel.h"
+#include "objects/joint/weld.h"
+#include "objects/part/part.h"
 #include "objects/script.h"
+#include "objects/service/workspace.h"
 #include <catch2/catch_test_macros.hpp>
+#include <cmath>
 
 extern int _dbgDataModelDestroyCount;
 
@@ -25,4 +30,88 @@ TEST_CASE("Datamodel destruction") {
         root = nullptr;
         REQUIRE(_dbgDataModelDestroyCount == prevCount + 1);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Datamodel cloning") {
+    auto root = DataModel::New();
+    root->Init(true);
+    auto workspace = root->GetService<Workspace>();
+
+    auto part0 = Part::New();
+    part0->name = "Part0";
+    part0->size = Vector3(4, 1, 2);
+    part0->cframe = CFrame(Vector3(1, 2, 3));
+    part0->anchored = true;
+    workspace->AddChild(part0);
+
+    auto part1 = Part::New();
+    part1->name = "Part1";
+    workspace->AddChild(part1);
+
+    // The weld comes before Part1 in the tree, so its reference has to be resolved later
+    auto weld = Weld::New();
+    weld->part0 = part0;
+    weld->part1 = part1;
+    part0->AddChild(weld);
+
+    auto copy = root->CloneModel();
+    auto copyWorkspace = copy->GetService<Workspace>();
+    REQUIRE(copyWorkspace != workspace);
+
+    auto copyPart0 = std::dynamic_pointer_cast<Part>(copyWorkspace->FindFirstChild("Part0"));
+    auto copyPart1 = std::dynamic_pointer_cast<Part>(copyWorkspace->FindFirstChild("Part1"));
+    REQUIRE(copyPart0 != nullptr);
+    REQUIRE(copyPart1 != nullptr);
+    REQUIRE(copyPart0->size == part0->size);
+    REQUIRE(copyPart0->cframe == part0->cframe);
+    REQUIRE(copyPart0->anchored);
+    REQUIRE(copyPart0->GetParent() == copyWorkspace);
+
+    auto copyWeld = std::dynamic_pointer_cast<Weld>(copyPart0->FindFirstChild("Weld"));
+    REQUIRE(copyWeld != nullptr);
+    REQUIRE(copyWeld->GetParent() == copyPart0);
+    REQUIRE(copyWeld->part0.lock() == copyPart0);
+    REQUIRE(copyWeld->part1.lock() == copyPart1);
+}
+
+TEST_CASE("Cloned workspace keeps physics settings") {
+    auto root = DataModel::New();
+    root->Init(true);
+    auto workspace = root->GetService<Workspace>();
+    workspace->gravity = 0.f;
+    workspace->collisionSteps = 3;
+
+    auto part = Part::New();
+    part->name = "Part";
+    part->cframe = CFrame(Vector3(0, 10, 0));
+    workspace->AddChild(part);
+
+    auto copy = root->CloneModel();
+    copy->Init(true);
+    auto copyWorkspace = copy->GetService<Workspace>();
+    REQUIRE(copyWorkspace->gravity == 0.f);
+
+    auto copyPart = std::dynamic_pointer_cast<Part>(copyWorkspace->FindFirstChild("Part"));
+    REQUIRE(copyPart != nullptr);
+
+    // With the default gravity the part would have fallen several studs by now
+    for (int i = 0; i < 30; i++)
+        copyWorkspace->PhysicsStep(1 / 60.f);
+    REQUIRE(std::abs(copyPart->position().Y() - 10) < 0.01f);
+}
+
+TEST_CASE("Cloned camera keeps its view") {
+    auto root = DataModel::New();
+    root->Init(true);
+    auto camera = root->GetService<Workspace>()->GetCamera();
+    camera->SetProperty("Focus", CFrame(Vector3(0, 0, 0))).expect();
+    camera->SetProperty("CFrame", CFrame(Vector3(10, 10, 10))).expect();
+    REQUIRE(camera->getPitch() != 0.f);
+    REQUIRE(camera->getYaw() != 0.f);
+
+    auto copy = root->CloneModel();
+    auto copyCamera = copy->GetService<Workspace>()->GetCamera();
+    REQUIRE(copyCamera != camera);
+    REQUIRE(copyCamera->getPitch() == camera->getPitch());
+    REQUIRE(copyCamera->getYaw() == camera->getYaw());
+}
@@ -0,0 +1,101 @@
+#include "objects/datamodel.h"
+#include "objects/joint/weld.h"
+#include "objects/part/part.h"
+#include "objects/service/workspace.h"
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <memory>
+
+TEST_CASE("Streaming XML place loading") {
+    auto root = DataModel::New();
+    root->Init(true);
+    auto workspace = root->GetService<Workspace>();
+
+    auto part0 = Part::New();
+    part0->name = "Part0 <&>";
+    part0->size = Vector3(4, 1, 2);
+    workspace->AddChild(part0);
+
+    auto part1 = Part::New();
+    part1->name = "Part1";
+    workspace->AddChild(part1);
+
+    // Weld refers to a part that comes after it in the file
+    auto weld = Weld::New();
+    weld->name = "Weld";
+    weld->part0 = part0;
+    weld->part1 = part1;
+    part0->AddChild(weld);
+
+    std::string path = (std::filesystem::temp_directory_path() / "obtest_xmlplace.obl").string();
+    root->SaveToFile(path);
+
+    size_t lastBytesRead = 0, lastTotalBytes = 0;
+    auto loaded = DataModel::LoadFromFile(path, [&](size_t bytesRead, size_t totalBytes) {
+        REQUIRE(bytesRead >= lastBytesRead);
+        lastBytesRead = bytesRead;
+        lastTotalBytes = totalBytes;
+    });
+
+    SECTION("Progress is reported up to the end of the file") {
+        REQUIRE(lastTotalBytes == std::filesystem::file_size(path));
+        REQUIRE(lastBytesRead == lastTotalBytes);
+    }
+
+    SECTION("Hierarchy, properties and references are restored") {
+        auto loadedWorkspace = loaded->GetService<Workspace>();
+        auto loadedPart0 = std::dynamic_pointer_cast<Part>(loadedWorkspace->FindFirstChild("Part0 <&>"));
+        auto loadedPart1 = std::dynamic_pointer_cast<Part>(loadedWorkspace->FindFirstChild("Part1"));
+        REQUIRE(loadedPart0 != nullptr);
+        REQUIRE(loadedPart1 != nullptr);
+        REQUIRE(loadedPart0->size == part0->size);
+
+        auto loadedWeld = std::dynamic_pointer_cast<Weld>(loadedPart0->FindFirstChild("Weld"));
+        REQUIRE(loadedWeld != nullptr);
+        REQUIRE(loadedWeld->part0.lock() == loadedPart0);
+        REQUIRE(loadedWeld->part1.lock() == loadedPart1);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Streaming XML place loading across worker batches") {
+    auto root = DataModel::New();
+    root->Init(true);
+    auto workspace = root->GetService<Workspace>();
+
+    // Enough parts that they are split over several worker jobs, with each
+    // weld referring to a part in the next batch
+    const int count = 1000;
+    std::vector<std::shared_ptr<Part>> parts;
+    for (int i = 0; i < count; i++) {
+        auto part = Part::New();
+        part->name = "Part" + std::to_string(i);
+        workspace->AddChild(part);
+        parts.push_back(part);
+    }
+    for (int i = 0; i < count; i++) {
+        auto weld = Weld::New();
+        weld->name = "Weld";
+        weld->part0 = parts[i];
+        weld->part1 = parts[(i + count / 2) % count];
+        parts[i]->AddChild(weld);
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "obtest_xmlplace_batches.obl").string();
+    root->SaveToFile(path);
+    auto loaded = DataModel::LoadFromFile(path);
+    auto loadedWorkspace = loaded->GetService<Workspace>();
+
+    for (int i = 0; i < count; i++) {
+        auto part = loadedWorkspace->FindFirstChild("Part" + std::to_string(i));
+        REQUIRE(part != nullptr);
+
+        auto weld = std::dynamic_pointer_cast<Weld>(part->FindFirstChild("Weld"));
+        REQUIRE(weld != nullptr);
+        REQUIRE(weld->part0.lock() == part);
+        REQUIRE(weld->part1.lock() == loadedWorkspace->FindFirstChild("Part" + std::to_string((i + count / 2) % count)));
+    }
+
+    std::filesystem::remove(path);
+}
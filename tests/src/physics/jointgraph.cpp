@@ -0,0 +1,94 @@
+#include "physics/jointgraph.h"
+#include "physics/world.h"
+#include "objects/part/part.h"
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <memory>
+
+static bool contains(const std::vector<BasePart*>& parts, BasePart* part) {
+    return std::find(parts.begin(), parts.end(), part) != parts.end();
+}
+
+TEST_CASE("Joint graph") {
+    // The graph only ever looks at the addresses of its parts and joints
+    auto a = Part::New(), b = Part::New(), c = Part::New(), d = Part::New();
+    PhysJointRecord ab, bc, cd;
+    JointGraph graph;
+
+    SECTION("Union") {
+        graph.addJoint(&ab, a.get(), b.get(), true);
+        graph.addJoint(&bc, b.get(), c.get(), true);
+
+        REQUIRE(graph.areJoined(a.get(), b.get()));
+        REQUIRE(!graph.areJoined(a.get(), c.get()));
+        REQUIRE(graph.areRigidlyConnected(a.get(), c.get()));
+        REQUIRE(graph.areConnected(a.get(), c.get()));
+        REQUIRE(!graph.areConnected(a.get(), d.get()));
+
+        std::vector<BasePart*> component = graph.rigidComponent(a.get());
+        REQUIRE(component.size() == 3);
+        REQUIRE(component[0] == a.get());
+        REQUIRE(contains(component, b.get()));
+        REQUIRE(contains(component, c.get()));
+
+        // Parts without any joint are their own component
+        REQUIRE(graph.rigidComponent(d.get()) == std::vector<BasePart*> { d.get() });
+    }
+
+    SECTION("Removal splits sets") {
+        graph.addJoint(&ab, a.get(), b.get(), true);
+        graph.addJoint(&bc, b.get(), c.get(), true);
+        graph.addJoint(&cd, c.get(), d.get(), false);
+        REQUIRE(graph.areConnected(a.get(), d.get()));
+
+        graph.removeJoint(&bc);
+
+        REQUIRE(!graph.areJoined(b.get(), c.get()));
+        REQUIRE(graph.areRigidlyConnected(a.get(), b.get()));
+        REQUIRE(!graph.areRigidlyConnected(a.get(), c.get()));
+        REQUIRE(!graph.areConnected(a.get(), d.get()));
+        REQUIRE(graph.areConnected(c.get(), d.get()));
+        REQUIRE(graph.rigidComponent(a.get()).size() == 2);
+
+        // Joints added after a removal still join sets
+        graph.addJoint(&bc, b.get(), c.get(), false);
+        REQUIRE(graph.areConnected(a.get(), d.get()));
+        REQUIRE(!graph.areRigidlyConnected(a.get(), c.get()));
+    }
+
+    SECTION("Rigid and non-rigid connections") {
+        graph.addJoint(&ab, a.get(), b.get(), true);
+        graph.addJoint(&bc, b.get(), c.get(), false);
+
+        REQUIRE(graph.areConnected(a.get(), c.get()));
+        REQUIRE(!graph.areRigidlyConnected(a.get(), c.get()));
+        REQUIRE(graph.rigidComponent(c.get()).size() == 1);
+
+        std::vector<BasePart*> direct = graph.connectedParts(b.get(), false);
+        REQUIRE(direct.size() == 2);
+        REQUIRE(contains(direct, a.get()));
+        REQUIRE(contains(direct, c.get()));
+
+        std::vector<BasePart*> direct2 = graph.connectedParts(a.get(), false);
+        REQUIRE(direct2 == std::vector<BasePart*> { b.get() });
+
+        std::vector<BasePart*> recursive = graph.connectedParts(a.get(), true);
+        REQUIRE(recursive.size() == 2);
+        REQUIRE(contains(recursive, b.get()));
+        REQUIRE(contains(recursive, c.get()));
+        REQUIRE(!contains(recursive, a.get()));
+    }
+
+    SECTION("Changing rigidity") {
+        graph.addJoint(&ab, a.get(), b.get(), true);
+        graph.addJoint(&bc, b.get(), c.get(), false);
+
+        graph.setRigid(&bc, true);
+        REQUIRE(graph.areRigidlyConnected(a.get(), c.get()));
+
+        graph.setRigid(&ab, false);
+        REQUIRE(!graph.areRigidlyConnected(a.get(), b.get()));
+        REQUIRE(graph.areRigidlyConnected(b.get(), c.get()));
+        REQUIRE(graph.areConnected(a.get(), c.get()));
+    }
+}